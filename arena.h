@@ -0,0 +1,407 @@
+//
+// C++ Interface: arena
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHARENA_H
+#define GRAPHARENA_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+namespace Graphs
+{
+	/**
+	@class Arena arena.h
+	@brief Chunked memory pool that is released all at once.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Allocations are carved off the end of large chunks. Freed blocks go on a
+	free list for their size and are handed out again before the chunk grows,
+	so churn doesn't bloat the arena. Nothing is given back to the system
+	until Release() (or destruction), which frees every chunk in one sweep.
+	*/
+	class Arena
+	{
+		public:
+			/**
+			@param chunkSize The size of each chunk in bytes.
+
+			Constructor
+			*/
+			explicit Arena(std::size_t chunkSize = 64 * 1024);
+
+			/**
+			Destructor
+			*/
+			~Arena(void);
+
+			/**
+			@param bytes The size of the block.
+			@return A block aligned for any type of that size.
+			*/
+			void *Allocate(std::size_t bytes);
+
+			/**
+			@param bytes The total size of the allocations about to be made.
+
+			Make sure the current chunk can take that much without growing again.
+			*/
+			void Reserve(std::size_t bytes);
+
+			/**
+			@param block The block to give back.
+			@param bytes The size it was allocated with.
+
+			Put a block on the free list for its size.
+			*/
+			void Deallocate(void *block, std::size_t bytes);
+
+			/**
+			Free every chunk. Anything still allocated from the arena is gone.
+			*/
+			void Release(void);
+
+			/**
+			@return The bytes held in chunks.
+			*/
+			std::size_t Footprint(void) const;
+
+		private:
+			static const std::size_t	Alignment = 16;	//!< Blocks whose size is a multiple of this start on this boundary.
+			static const std::size_t	Granule = 8;	//!< Every block's size is a multiple of this (and it starts on this boundary).
+
+			/**
+			@brief A freed block, threaded on to its size's free list.
+			*/
+			struct FreeBlock
+			{
+				FreeBlock	*next;	//!< The next free block of the same size.
+			};
+
+			std::vector<char*>								chunks;		//!< Every chunk we've allocated.
+			boost::unordered_map<std::size_t, FreeBlock*>	freeBlocks;	//!< Free lists by block size.
+			std::size_t										chunkSize;	//!< The size of a regular chunk.
+			char											*cursor;	//!< Next free byte in the current chunk.
+			char											*limit;		//!< End of the current chunk.
+			std::size_t										footprint;	//!< The bytes held in chunks.
+
+			/**
+			@param bytes The requested size.
+			@return The size rounded up to the granule (and big enough to hold a FreeBlock).
+			*/
+			static std::size_t Round(std::size_t bytes);
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			Arena(const Arena &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			Arena &operator=(const Arena &);
+	};
+
+	/**
+	@class ArenaAllocator arena.h
+	@brief Standard allocator that draws from an Arena.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	A default constructed allocator has no arena and falls back to the free
+	store, so containers using it still work outside of a Graph.
+	*/
+	template<class U>
+	class ArenaAllocator
+	{
+		public:
+			typedef U				value_type;			//!< What we allocate.
+			typedef U				*pointer;			//!< Pointer to what we allocate.
+			typedef const U			*const_pointer;		//!< Constant pointer to what we allocate.
+			typedef U				&reference;			//!< Reference to what we allocate.
+			typedef const U			&const_reference;	//!< Constant reference to what we allocate.
+			typedef std::size_t		size_type;			//!< Counts of objects.
+			typedef std::ptrdiff_t	difference_type;	//!< Distances between objects.
+
+			/**
+			@brief The same allocator for another type.
+			*/
+			template<class V>
+			struct rebind
+			{
+				typedef ArenaAllocator<V>	other;	//!< The rebound allocator.
+			};
+
+			/**
+			@param arena The arena to draw from, or NULL for the free store.
+
+			Constructor
+			*/
+			ArenaAllocator(Arena *arena = NULL);
+
+			/**
+			@param other The allocator (of any type) whose arena to share.
+
+			Copy Constructor
+			*/
+			template<class V>
+			ArenaAllocator(const ArenaAllocator<V> &other);
+
+			/**
+			@param count The number of objects to make room for.
+			@return The uninitialised storage.
+			*/
+			pointer allocate(size_type count, const void * = NULL);
+
+			/**
+			@param storage Storage from allocate().
+			@param count The number of objects it was allocated for.
+			*/
+			void deallocate(pointer storage, size_type count);
+
+			/**
+			@param storage Where to build the object.
+			@param value What to copy.
+			*/
+			void construct(pointer storage, const U &value);
+
+			/**
+			@param object The object to tear down.
+			*/
+			void destroy(pointer object);
+
+			/**
+			@return The largest count allocate() could be asked for.
+			*/
+			size_type max_size(void) const;
+
+			/**
+			@param object An object.
+			@return Its address.
+			*/
+			pointer address(reference object) const;
+
+			/**
+			@param object An object.
+			@return Its address.
+			*/
+			const_pointer address(const_reference object) const;
+
+			/**
+			@return The arena we draw from, or NULL.
+			*/
+			Arena *GetArena(void) const;
+
+		private:
+			Arena	*arena;	//!< Where the memory comes from.
+	};
+
+	template<class U, class V>
+	bool operator==(const ArenaAllocator<U> &, const ArenaAllocator<V> &);
+	template<class U, class V>
+	bool operator!=(const ArenaAllocator<U> &, const ArenaAllocator<V> &);
+
+	inline Arena::Arena(std::size_t chunkSize)
+	:chunks(std::vector<char*>()), freeBlocks(boost::unordered_map<std::size_t, FreeBlock*>()), chunkSize(Round(chunkSize)), cursor(NULL), limit(NULL), footprint(0)
+	{
+	}
+
+	inline Arena::~Arena(void)
+	{
+		Release();
+	}
+
+	inline std::size_t Arena::Round(std::size_t bytes)
+	{
+		if (bytes < sizeof(FreeBlock))
+			bytes = sizeof(FreeBlock);
+		return (bytes + Granule - 1) / Granule * Granule;
+	}
+
+	inline void *Arena::Allocate(std::size_t bytes)
+	{
+		bytes = Round(bytes);
+
+		/*
+		Recycle a freed block of the same size if there is one.
+		*/
+		boost::unordered_map<std::size_t, FreeBlock*>::iterator freeList = freeBlocks.find(bytes);
+		if (freeList != freeBlocks.end() && freeList->second != NULL)
+		{
+			FreeBlock	*block = freeList->second;	// The block we're handing out.
+
+			freeList->second = block->next;
+			return block;
+		}
+
+		/*
+		A type's size is always a multiple of its alignment, so only blocks
+		sized in whole Alignments need to start on an Alignment boundary; the
+		rest can be packed at the granule. Since the free lists go by size,
+		recycled blocks keep the same guarantee.
+		*/
+		std::size_t	padding = 0;	// Bytes skipped to align the block.
+
+		if (bytes % Alignment == 0)
+			padding = (Alignment - reinterpret_cast<std::size_t>(cursor) % Alignment) % Alignment;
+
+		if (static_cast<std::size_t>(limit - cursor) < padding + bytes)
+		{
+			/*
+			Oversized blocks get a chunk of their own so the current chunk isn't wasted.
+			*/
+			if (bytes > chunkSize)
+			{
+				char	*chunk = static_cast<char*>(::operator new(bytes));	// The dedicated chunk.
+
+				chunks.push_back(chunk);
+				footprint += bytes;
+				return chunk;
+			}
+
+			cursor = static_cast<char*>(::operator new(chunkSize));
+			limit = cursor + chunkSize;
+			chunks.push_back(cursor);
+			footprint += chunkSize;
+			padding = 0;
+		}
+
+		cursor += padding;
+
+		void	*block = cursor;	// The block we're handing out.
+
+		cursor += bytes;
+		return block;
+	}
+
+	inline void Arena::Reserve(std::size_t bytes)
+	{
+		bytes = Round(bytes);
+		if (static_cast<std::size_t>(limit - cursor) >= bytes)
+			return;
+		if (bytes < chunkSize)
+			bytes = chunkSize;
+		cursor = static_cast<char*>(::operator new(bytes));
+		limit = cursor + bytes;
+		chunks.push_back(cursor);
+		footprint += bytes;
+		return;
+	}
+
+	inline void Arena::Deallocate(void *block, std::size_t bytes)
+	{
+		FreeBlock	*freed = static_cast<FreeBlock*>(block);	// The block going on the free list.
+		FreeBlock	*&head = freeBlocks[Round(bytes)];			// The free list for its size.
+
+		freed->next = head;
+		head = freed;
+		return;
+	}
+
+	inline void Arena::Release(void)
+	{
+		for (std::vector<char*>::iterator i = chunks.begin(); i != chunks.end(); i++)
+			::operator delete(*i);
+		chunks.clear();
+		freeBlocks.clear();
+		cursor = limit = NULL;
+		footprint = 0;
+		return;
+	}
+
+	inline std::size_t Arena::Footprint(void) const
+	{
+		return footprint;
+	}
+
+	template<class U>
+	ArenaAllocator<U>::ArenaAllocator(Arena *arena)
+	:arena(arena)
+	{
+	}
+
+	template<class U>
+	template<class V>
+	ArenaAllocator<U>::ArenaAllocator(const ArenaAllocator<V> &other)
+	:arena(other.GetArena())
+	{
+	}
+
+	template<class U>
+	typename ArenaAllocator<U>::pointer ArenaAllocator<U>::allocate(size_type count, const void *)
+	{
+		if (arena == NULL)
+			return static_cast<pointer>(::operator new(count * sizeof(U)));
+		return static_cast<pointer>(arena->Allocate(count * sizeof(U)));
+	}
+
+	template<class U>
+	void ArenaAllocator<U>::deallocate(pointer storage, size_type count)
+	{
+		if (arena == NULL)
+			::operator delete(storage);
+		else
+			arena->Deallocate(storage, count * sizeof(U));
+		return;
+	}
+
+	template<class U>
+	void ArenaAllocator<U>::construct(pointer storage, const U &value)
+	{
+		new (static_cast<void*>(storage)) U(value);
+		return;
+	}
+
+	template<class U>
+	void ArenaAllocator<U>::destroy(pointer object)
+	{
+		object->~U();
+		return;
+	}
+
+	template<class U>
+	typename ArenaAllocator<U>::size_type ArenaAllocator<U>::max_size(void) const
+	{
+		return static_cast<size_type>(-1) / sizeof(U);
+	}
+
+	template<class U>
+	typename ArenaAllocator<U>::pointer ArenaAllocator<U>::address(reference object) const
+	{
+		return &object;
+	}
+
+	template<class U>
+	typename ArenaAllocator<U>::const_pointer ArenaAllocator<U>::address(const_reference object) const
+	{
+		return &object;
+	}
+
+	template<class U>
+	Arena *ArenaAllocator<U>::GetArena(void) const
+	{
+		return arena;
+	}
+
+	template<class U, class V>
+	bool operator==(const ArenaAllocator<U> &a, const ArenaAllocator<V> &b)
+	{
+		return a.GetArena() == b.GetArena();
+	}
+
+	template<class U, class V>
+	bool operator!=(const ArenaAllocator<U> &a, const ArenaAllocator<V> &b)
+	{
+		return a.GetArena() != b.GetArena();
+	}
+}
+
+#endif
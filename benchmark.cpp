@@ -0,0 +1,369 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by Alex Brandt                                     *
+ *   alunduil@alunduil.com                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; version 2 of the License.               *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful.       *
+ *   but WITHOUT ANY WARRANTY: without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc..                                       *
+ *   59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.              *
+ ***************************************************************************/
+
+/**
+@file benchmark.cpp
+@brief Timed harnesses for the Graph on synthetic graphs.
+@author Alex Brandt <alunduil@alunduil.com>
+
+Usage: graphbench &lt;grid|random|rmat|road&gt; &lt;vertices&gt; [degree] [queries] [seed]
+
+Builds a Directed, Weighted Graph with the named Generator, then times
+building it, its footprint, lookups, single and batched shortest path
+queries and edge insertion (plus the searches' own counters and latency
+histogram when built with GRAPHS_INSTRUMENT). Every result is printed as one JSON object per
+line, each carrying the generator, vertex and edge counts, so runs can be
+collected and compared release to release. 'make benchmark' runs all four
+generators at SCALE vertices.
+*/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <boost/chrono.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "graph.h"
+#include "graphbuilder.h"
+#include "frozengraph.h"
+#include "keyindex.h"
+#include "generator.h"
+
+using namespace Graphs;
+using namespace std;
+using namespace boost::lambda;
+
+typedef boost::chrono::steady_clock	Clock;	//!< What everything is timed with.
+
+/**
+@param start When the timing started.
+@return The seconds since.
+*/
+static double Seconds(Clock::time_point start)
+{
+	return boost::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+@param prefix The fields every line carries.
+@param benchmark The name of the harness.
+@param fields The harness's own fields (starting with a comma).
+
+Print one result.
+*/
+static void Report(const string &prefix, const string &benchmark, const string &fields)
+{
+	cout << "{\"benchmark\":\"" << benchmark << "\"," << prefix << fields << "}" << endl;
+	return;
+}
+
+/**
+@param stats What an engine's queries did.
+@return The queries, their work per query and their latency percentiles in microseconds, as JSON fields.
+*/
+static string Work(const GraphStats &stats)
+{
+	const LatencyHistogram	&latencies = stats.Latencies();
+	const unsigned long		answered = max(stats.Queries(), 1UL);
+	ostringstream			out;	// The fields.
+
+	out << ",\"count\":" << stats.Queries()
+		<< ",\"settled_per_query\":" << stats.Settled() / answered
+		<< ",\"relaxed_per_query\":" << stats.Relaxed() / answered
+		<< ",\"pushes_per_query\":" << stats.Pushes() / answered
+		<< ",\"pops_per_query\":" << stats.Pops() / answered
+		<< ",\"decreases_per_query\":" << stats.Decreases() / answered
+		<< ",\"mean_us\":" << latencies.Mean() / 1e3
+		<< ",\"p50_us\":" << latencies.Percentile(0.5) / 1e3
+		<< ",\"p99_us\":" << latencies.Percentile(0.99) / 1e3
+		<< ",\"max_us\":" << latencies.Max() / 1e3;
+	return out.str();
+}
+
+/**
+@param samples Seconds taken by each operation (sorted on return).
+@return The count, mean, median, 99th percentile and maximum in microseconds, as JSON fields.
+*/
+static string Latencies(vector<double> &samples)
+{
+	ostringstream	out;		// The fields.
+	double			total = 0;	// Sum of the samples.
+
+	if (samples.empty())
+		return ",\"count\":0";
+	sort(samples.begin(), samples.end());
+	for (vector<double>::iterator i = samples.begin(); i != samples.end(); i++)
+		total += *i;
+	out << ",\"count\":" << samples.size()
+		<< ",\"mean_us\":" << total / samples.size() * 1e6
+		<< ",\"p50_us\":" << samples[samples.size() / 2] * 1e6
+		<< ",\"p99_us\":" << samples[samples.size() * 99 / 100] * 1e6
+		<< ",\"max_us\":" << samples.back() * 1e6;
+	return out.str();
+}
+
+/**
+@param builder Where the edges go.
+@param edges Every edge of the graph.
+@param threads How many loaders share the edges.
+@param worker The loader's number.
+
+A loader thread for the builder harness: insert every threads-th edge, starting from its own number.
+*/
+static void LoadShard(GraphBuilder<int> &builder, const vector<Graph<int>::EdgeTriple> &edges, int threads, int worker)
+{
+	for (size_t i = worker; i < edges.size(); i += threads)
+		builder.InsertEdge(worker, boost::get<0>(edges[i]), boost::get<1>(edges[i]), boost::get<2>(edges[i]));
+	return;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3)
+	{
+		cerr << "usage: " << argv[0] << " <grid|random|rmat|road> <vertices> [degree] [queries] [seed]" << endl;
+		return 1;
+	}
+
+	const string				generator = argv[1];							//!< Which kind of graph.
+	const int					vertices = max(4, atoi(argv[2])),				//!< Roughly how many vertices.
+								degree = argc > 3 ? max(1, atoi(argv[3])) : 8,	//!< Arcs per vertex for random and rmat.
+								queries = argc > 4 ? max(1, atoi(argv[4])) : 1000,	//!< Shortest path queries to time.
+								side = static_cast<int>(ceil(sqrt(static_cast<double>(vertices))));	//!< Lattice side for grid and road.
+	const unsigned int			seed = argc > 5 ? atoi(argv[5]) : 1;			//!< Where the random numbers start.
+	Graph<int>					graph(Directed, Weighted);						//!< The graph under test.
+	Generator<int>				generate(graph, seed);							//!< Fills it.
+	boost::random::mt19937		random(seed);									//!< Picks the query vertices.
+	ostringstream				prefix;											//!< Fields every result carries.
+	Clock::time_point			start = Clock::now();							//!< When the current harness started.
+
+	/*
+	Build.
+	*/
+
+	if (generator == "grid")
+		generate.Grid(side, side);
+	else if (generator == "random")
+		generate.ErdosRenyi(vertices, vertices * degree);
+	else if (generator == "rmat")
+		generate.RMat(static_cast<int>(ceil(log(static_cast<double>(vertices)) / log(2.0))), vertices * degree);
+	else if (generator == "road")
+		generate.Road(side, side);
+	else
+	{
+		cerr << "unknown generator: " << generator << endl;
+		return 1;
+	}
+
+	const double	buildSeconds = Seconds(start);	// Time to generate and insert everything.
+	const int		count = graph.IndexCount();		// Vertex identifiers in use.
+
+	boost::random::uniform_int_distribution<int>	pick(0, count - 1);	// A vertex at random.
+
+	prefix << "\"generator\":\"" << generator << "\",\"vertices\":" << graph.VertexCount() << ",\"edges\":" << graph.EdgeCount() << ",\"seed\":" << seed;
+	{
+		ostringstream	fields;	// The build's own fields.
+
+		fields << ",\"seconds\":" << buildSeconds << ",\"edges_per_second\":" << graph.EdgeCount() / max(buildSeconds, 1e-9);
+		Report(prefix.str(), "build", fields.str());
+	}
+	{
+		ostringstream	fields;	// The footprint's own fields.
+
+		fields << ",\"bytes\":" << graph.Footprint() << ",\"bytes_per_edge\":" << static_cast<double>(graph.Footprint()) / max(1, graph.EdgeCount());
+		Report(prefix.str(), "footprint", fields.str());
+	}
+
+	/*
+	Lookups: the linear Find() against a KeyIndex.
+	*/
+
+	{
+		vector<double>	samples;	// Seconds per lookup.
+
+		for (int i = 0; i < min(queries, 100); i++)
+		{
+			const int	wanted = graph.VertexAt(pick(random))->Get();	// The data to look for.
+
+			start = Clock::now();
+			graph.Find(_1 == wanted);
+			samples.push_back(Seconds(start));
+		}
+		Report(prefix.str(), "find", Latencies(samples));
+	}
+	{
+		vector<double>	samples;	// Seconds per lookup.
+
+		start = Clock::now();
+
+		KeyIndex<int>	index(graph);	// The vertices by data.
+		ostringstream	fields;			// The index's own fields.
+
+		fields << ",\"build_seconds\":" << Seconds(start);
+		for (int i = 0; i < queries; i++)
+		{
+			const int	wanted = graph.VertexAt(pick(random))->Get();	// The data to look for.
+
+			start = Clock::now();
+			index.Lookup(wanted);
+			samples.push_back(Seconds(start));
+		}
+		Report(prefix.str(), "lookup", fields.str() + Latencies(samples));
+	}
+
+	/*
+	The same graph again through a GraphBuilder, for one loader thread and
+	doubling up to twice the cores, timing the loaders and Finish() apart.
+	*/
+
+	{
+		vector<Graph<int>::EdgeTriple>	edges;	// Every edge, as the loaders will insert them.
+		const int						most = max(2, 2 * static_cast<int>(boost::thread::hardware_concurrency()));	// The last thread count tried.
+
+		edges.reserve(graph.EdgeCount());
+		for (int i = 0; i < count; i++)
+			for (Vertex<int>::EdgeIterator j = graph.VertexAt(i)->EdgesBegin(); j != graph.VertexAt(i)->EdgesEnd(); j++)
+				edges.push_back(Graph<int>::EdgeTriple(i, boost::get<0>(*j)->Index(), boost::get<1>(*j)));
+		for (int threads = 1; threads <= most; threads *= 2)
+		{
+			Graph<int>			built(Directed, Weighted);	// The copy being built.
+			GraphBuilder<int>	builder(built, threads);	// Stages the loaders' work.
+			ThreadPool			loaders(threads);			// One per stage.
+			ostringstream		fields;						// The builder's own fields.
+			double				loadSeconds,
+								finishSeconds;
+
+			for (int i = 0; i < count; i++)
+				builder.InsertVertex(0, graph.VertexAt(i)->Get());
+			start = Clock::now();
+			loaders.Run(boost::bind(&LoadShard, boost::ref(builder), boost::cref(edges), threads, boost::placeholders::_1));
+			loadSeconds = Seconds(start);
+			start = Clock::now();
+			builder.Finish();
+			finishSeconds = Seconds(start);
+			fields << ",\"threads\":" << threads << ",\"load_seconds\":" << loadSeconds << ",\"finish_seconds\":" << finishSeconds << ",\"edges_per_second\":" << built.EdgeCount() / max(loadSeconds + finishSeconds, 1e-9);
+			Report(prefix.str(), "builder", fields.str());
+		}
+	}
+
+	/*
+	Single queries, on the Graph and on a FrozenGraph of it.
+	*/
+
+	vector<Graph<int>::Query>	pairs;	// The source and destination of each query.
+
+	for (int i = 0; i < queries; i++)
+		pairs.push_back(Graph<int>::Query(graph.VertexAt(pick(random)), graph.VertexAt(pick(random))));
+	{
+		vector<double>	samples;	// Seconds per query.
+
+		for (vector<Graph<int>::Query>::iterator i = pairs.begin(); i != pairs.end(); i++)
+		{
+			start = Clock::now();
+			graph.ShortestPath(*i->first, *i->second);
+			samples.push_back(Seconds(start));
+		}
+		Report(prefix.str(), "query", ",\"engine\":\"graph\"" + Latencies(samples));
+	}
+	if (Instrumented)
+		Report(prefix.str(), "stats", ",\"engine\":\"graph\"" + Work(graph.Stats()));
+	graph.ResetStats();
+	{
+		vector<double>	samples;	// Seconds per query.
+
+		for (vector<Graph<int>::Query>::iterator i = pairs.begin(); i != pairs.end(); i++)
+		{
+			start = Clock::now();
+			graph.BidirectionalShortestPath(*i->first, *i->second);
+			samples.push_back(Seconds(start));
+		}
+		Report(prefix.str(), "query", ",\"engine\":\"graph_bidirectional\"" + Latencies(samples));
+	}
+	if (Instrumented)
+		Report(prefix.str(), "stats", ",\"engine\":\"graph_bidirectional\"" + Work(graph.Stats()));
+	{
+		start = Clock::now();
+
+		FrozenGraph<int>	frozen(graph);	// Compacted copy of the graph.
+		ostringstream		fields;			// The engine's own fields.
+		vector<double>		samples,		// Seconds per query.
+							bidirectional;	// Seconds per bidirectional query.
+
+		fields << ",\"engine\":\"frozen\",\"build_seconds\":" << Seconds(start);
+		for (vector<Graph<int>::Query>::iterator i = pairs.begin(); i != pairs.end(); i++)
+		{
+			start = Clock::now();
+			frozen.ShortestPath(*i->first, *i->second);
+			samples.push_back(Seconds(start));
+		}
+		Report(prefix.str(), "query", fields.str() + Latencies(samples));
+		if (Instrumented)
+			Report(prefix.str(), "stats", ",\"engine\":\"frozen\"" + Work(frozen.Stats()));
+		frozen.ResetStats();
+		for (vector<Graph<int>::Query>::iterator i = pairs.begin(); i != pairs.end(); i++)
+		{
+			start = Clock::now();
+			frozen.BidirectionalShortestPath(*i->first, *i->second);
+			bidirectional.push_back(Seconds(start));
+		}
+		Report(prefix.str(), "query", ",\"engine\":\"frozen_bidirectional\"" + Latencies(bidirectional));
+		if (Instrumented)
+			Report(prefix.str(), "stats", ",\"engine\":\"frozen_bidirectional\"" + Work(frozen.Stats()));
+	}
+
+	/*
+	Batch queries across a pool of one thread per core.
+	*/
+
+	{
+		ThreadPool		pool;	// The workers.
+		ostringstream	fields;	// The batch's own fields.
+		double			seconds;
+
+		start = Clock::now();
+		graph.ShortestPaths(pairs, pool);
+		seconds = Seconds(start);
+		fields << ",\"threads\":" << pool.Size() << ",\"count\":" << pairs.size() << ",\"seconds\":" << seconds << ",\"queries_per_second\":" << pairs.size() / max(seconds, 1e-9);
+		Report(prefix.str(), "batch", fields.str());
+	}
+
+	/*
+	Edge insertion, one at a time, last since it changes the graph.
+	*/
+
+	{
+		const int		inserts = min(count, 100000);	// Edges to insert.
+		ostringstream	fields;							// The insertion's own fields.
+		double			seconds;
+
+		start = Clock::now();
+		for (int i = 0; i < inserts; i++)
+			graph.InsertEdge(*graph.VertexAt(pick(random)), *graph.VertexAt(pick(random)), 1);
+		seconds = Seconds(start);
+		fields << ",\"count\":" << inserts << ",\"mean_ns\":" << seconds / inserts * 1e9;
+		Report(prefix.str(), "insert_edge", fields.str());
+	}
+
+	return 0;
+}
@@ -0,0 +1,374 @@
+//
+// C++ Interface: breadthfirst
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHBREADTHFIRST_H
+#define GRAPHBREADTHFIRST_H
+
+#include <vector>
+#include <list>
+#include <algorithm>
+#include <queue>
+#include <boost/atomic.hpp>
+#include <boost/atomic/atomic_ref.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/cstdint.hpp>
+
+#include "graph.h"
+#include "threadpool.h"
+
+namespace Graphs
+{
+	/**
+	@class BreadthFirst breadthfirst.h
+	@brief Hop counts from one source to every vertex, direction optimizing.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	A breadth first search (Beamer, Asanovic and Patterson) that steps each
+	level one of two ways. Top-down, every frontier vertex looks at its
+	out-edges and claims the neighbors nobody has reached yet; this is cheap
+	while the frontier is small. Bottom-up, every unreached vertex looks at
+	its in-edges for a parent on the frontier and stops at the first; once
+	the frontier holds a good part of the graph, most of those checks find
+	one straight away and far fewer edges are read. The search starts
+	top-down, goes bottom-up when the frontier's out-edges outnumber a
+	fourteenth of the edges not yet explored, and comes back when the
+	frontier falls below a twenty-fourth of the vertices.
+
+	Reached vertices and the frontier are bitmaps, a bit per vertex, so the
+	bottom-up checks stay in cache. Either step can be shared over a
+	ThreadPool: top-down workers claim neighbors with an atomic or on the
+	bitmap word, bottom-up workers claim whole words and so never contend.
+
+	Edge weights are ignored. Like FrozenGraph, the adjacency (both ways) is
+	copied into compressed sparse rows when the engine is built, and later
+	changes to the Graph aren't seen.
+	*/
+	template<class T>
+	class BreadthFirst
+	{
+		public:
+			/**
+			@param graph The Graph to search.
+
+			Constructor
+			*/
+			explicit BreadthFirst(const Graph<T> &graph);
+
+			/**
+			@param source The source vertex.
+
+			Find the hop count from the source to every vertex, on this thread.
+			*/
+			void Search(const Vertex<T> &source);
+
+			/**
+			@param source The source vertex.
+			@param pool The threads to search with.
+
+			Find the hop count from the source to every vertex.
+			*/
+			void Search(const Vertex<T> &source, ThreadPool &pool);
+
+			/**
+			@param vertex A vertex of the Graph.
+			@return The fewest edges from the last Search()'s source, or Infinity if it can't be reached.
+			*/
+			int Hops(const Vertex<T> &vertex) const;
+
+			/**
+			@param vertex A vertex of the Graph.
+			@return The vertex before it on a shortest path, or NULL for the source and unreachable vertices.
+			*/
+			Vertex<T> * Parent(const Vertex<T> &vertex) const;
+
+			/**
+			@param vertex The destination vertex.
+			@return A queue that is the path to follow (empty if the destination can't be reached).
+			*/
+			std::queue<Vertex<T>*> PathTo(const Vertex<T> &vertex) const;
+
+		private:
+			typedef boost::uint64_t	Word;	//!< A piece of a bitmap.
+
+			static const int	Bits = 64;		//!< Vertices per Word.
+			static const int	Alpha = 14;		//!< Go bottom-up once the frontier's edges pass the unexplored edges over this.
+			static const int	Beta = 24;		//!< Go back top-down once the frontier falls below the vertices over this.
+
+			std::vector<int>				offsets;		//!< Where each vertex's edges start.
+			std::vector<int>				targets;		//!< The end of each edge.
+			std::vector<int>				reverseOffsets;	//!< Where each vertex's incoming edges start.
+			std::vector<int>				sources;		//!< The start of each incoming edge.
+			std::vector<Vertex<T>*>			vertices;		//!< The Graph's vertices by dense identifier.
+			std::vector<int>				hops;			//!< Hop counts by dense identifier.
+			std::vector<int>				parents;		//!< Parents by dense identifier (-1 for none).
+			std::vector<Word>				visited;		//!< Bitmap of the vertices reached.
+			std::vector<Word>				frontier;		//!< Bitmap of the current level (bottom-up only).
+			std::vector<int>				current;		//!< The current level as a list.
+			std::vector<std::vector<int> >	found;			//!< Each worker's share of the next level.
+			int								level;			//!< The hop count of the current level.
+
+			/**
+			@param source The source vertex.
+			@param pool The threads to search with (NULL to search on this thread).
+			*/
+			void Traverse(const Vertex<T> &source, ThreadPool *pool);
+
+			/**
+			@param step The step to take.
+			@param pool The threads to take it with (NULL to take it on this thread).
+
+			Run one level's step, as worker 0 or on every worker of the pool.
+			*/
+			void Step(void (BreadthFirst<T>::*step)(boost::atomic<int> &, int), ThreadPool *pool);
+
+			/**
+			@param next The next entry of the current level to claim.
+			@param worker The worker's number.
+
+			A worker: claim the unreached neighbors of the frontier.
+			*/
+			void TopDown(boost::atomic<int> &next, int worker);
+
+			/**
+			@param next The next bitmap word to claim.
+			@param worker The worker's number.
+
+			A worker: find a parent on the frontier for the unreached vertices.
+			*/
+			void BottomUp(boost::atomic<int> &next, int worker);
+	};
+
+	template<class T>
+	BreadthFirst<T>::BreadthFirst(const Graph<T> &graph)
+	:offsets(std::vector<int>()), targets(std::vector<int>()), reverseOffsets(std::vector<int>()), sources(std::vector<int>()), vertices(std::vector<Vertex<T>*>()), hops(std::vector<int>()), parents(std::vector<int>()), visited(std::vector<Word>()), frontier(std::vector<Word>()), current(std::vector<int>()), found(std::vector<std::vector<int> >()), level(0)
+	{
+		int	edges = 0;	// Total adjacency entries, so the rows are allocated once.
+
+		for (int i = 0; i < graph.IndexCount(); i++)
+		{
+			vertices.push_back(graph.VertexAt(i));
+			if (vertices.back() != NULL)
+				edges += vertices.back()->Degree();
+		}
+
+		offsets.reserve(vertices.size() + 1);
+		targets.reserve(edges);
+		offsets.push_back(0);
+		for (typename std::vector<Vertex<T>*>::iterator i = vertices.begin(); i != vertices.end(); i++)
+		{
+			if (*i != NULL)
+				for (typename Vertex<T>::EdgeIterator j = (*i)->EdgesBegin(); j != (*i)->EdgesEnd(); j++)
+					targets.push_back(boost::get<0>(*j)->Index());
+			offsets.push_back(targets.size());
+		}
+
+		/*
+		Transpose the rows for the bottom-up steps, as FrozenGraph does.
+		*/
+		reverseOffsets.assign(vertices.size() + 1, 0);
+		sources.resize(targets.size());
+		for (std::size_t i = 0; i < targets.size(); i++)
+			reverseOffsets[targets[i] + 1]++;
+		for (std::size_t i = 1; i < reverseOffsets.size(); i++)
+			reverseOffsets[i] += reverseOffsets[i - 1];
+
+		std::vector<int>	fill(reverseOffsets.begin(), reverseOffsets.end() - 1);	// The next free slot in each reverse row.
+
+		for (int i = 0; i < static_cast<int>(vertices.size()); i++)
+			for (int j = offsets[i]; j < offsets[i + 1]; j++)
+				sources[fill[targets[j]]++] = i;
+	}
+
+	template<class T>
+	void BreadthFirst<T>::Search(const Vertex<T> &source)
+	{
+		Traverse(source, NULL);
+		return;
+	}
+
+	template<class T>
+	void BreadthFirst<T>::Search(const Vertex<T> &source, ThreadPool &pool)
+	{
+		Traverse(source, &pool);
+		return;
+	}
+
+	template<class T>
+	int BreadthFirst<T>::Hops(const Vertex<T> &vertex) const
+	{
+		if (vertex.Index() < 0 || vertex.Index() >= static_cast<int>(hops.size()))
+			return Infinity;
+		return hops[vertex.Index()];
+	}
+
+	template<class T>
+	Vertex<T> * BreadthFirst<T>::Parent(const Vertex<T> &vertex) const
+	{
+		if (vertex.Index() < 0 || vertex.Index() >= static_cast<int>(parents.size()) || parents[vertex.Index()] == -1)
+			return NULL;
+		return vertices[parents[vertex.Index()]];
+	}
+
+	template<class T>
+	std::queue<Vertex<T>*> BreadthFirst<T>::PathTo(const Vertex<T> &vertex) const
+	{
+		using namespace std;
+
+		list<Vertex<T>*>		shortestPathList;	// The found shortest path.
+		queue<Vertex<T>*>		shortestPath;		// The found shortest path (clean).
+
+		if (Hops(vertex) == Infinity)
+			return shortestPath;
+		for (int i = vertex.Index(); i != -1; i = parents[i])
+			shortestPathList.push_front(vertices[i]);
+		for (typename list<Vertex<T>*>::iterator i = shortestPathList.begin(); i != shortestPathList.end(); i++)
+			shortestPath.push(*i);
+		return shortestPath;
+	}
+
+	template<class T>
+	void BreadthFirst<T>::Traverse(const Vertex<T> &source, ThreadPool *pool)
+	{
+		const int	count = vertices.size();			// Vertex identifiers.
+		long long	unexplored = targets.size(),		// Edges leaving vertices not reached yet.
+					outgoing = 0;						// Edges leaving the frontier.
+		bool		bottomUp = false;					// Which way the last level was stepped.
+
+		hops.assign(count, Infinity);
+		parents.assign(count, -1);
+		visited.assign((count + Bits - 1) / Bits, 0);
+		frontier.assign(visited.size(), 0);
+		found.assign(pool == NULL ? 1 : pool->Size(), std::vector<int>());
+		current.clear();
+		if (source.Index() < 0 || source.Index() >= count)
+			return;
+
+		hops[source.Index()] = 0;
+		visited[source.Index() / Bits] |= Word(1) << (source.Index() % Bits);
+		current.push_back(source.Index());
+
+		for (level = 0; !current.empty(); level++)
+		{
+			outgoing = 0;
+			for (std::vector<int>::iterator i = current.begin(); i != current.end(); i++)
+				outgoing += offsets[*i + 1] - offsets[*i];
+			unexplored -= outgoing;
+
+			/*
+			Switch on the sizes of this level (Beamer's heuristic).
+			*/
+			if (!bottomUp && outgoing > unexplored / Alpha)
+				bottomUp = true;
+			else if (bottomUp && static_cast<int>(current.size()) < count / Beta)
+				bottomUp = false;
+
+			if (bottomUp)
+			{
+				std::fill(frontier.begin(), frontier.end(), 0);
+				for (std::vector<int>::iterator i = current.begin(); i != current.end(); i++)
+					frontier[*i / Bits] |= Word(1) << (*i % Bits);
+				Step(&BreadthFirst<T>::BottomUp, pool);
+			}
+			else
+				Step(&BreadthFirst<T>::TopDown, pool);
+
+			current.clear();
+			for (typename std::vector<std::vector<int> >::iterator i = found.begin(); i != found.end(); i++)
+			{
+				current.insert(current.end(), i->begin(), i->end());
+				i->clear();
+			}
+		}
+		return;
+	}
+
+	template<class T>
+	void BreadthFirst<T>::Step(void (BreadthFirst<T>::*step)(boost::atomic<int> &, int), ThreadPool *pool)
+	{
+		boost::atomic<int>	next(0);	// The next piece to claim.
+
+		if (pool == NULL)
+			(this->*step)(next, 0);
+		else
+			pool->Run(boost::bind(step, this, boost::ref(next), boost::placeholders::_1));
+		return;
+	}
+
+	template<class T>
+	void BreadthFirst<T>::TopDown(boost::atomic<int> &next, int worker)
+	{
+		const int			claim = 64;					// Entries claimed at once.
+		const int			size = current.size();
+		std::vector<int>	&mine = found[worker];		// This worker's share of the next level.
+
+		for (int first = next.fetch_add(claim); first < size; first = next.fetch_add(claim))
+			for (int i = first; i < first + claim && i < size; i++)
+			{
+				const int	vertex = current[i];
+
+				for (int edge = offsets[vertex]; edge < offsets[vertex + 1]; edge++)
+				{
+					const int				end = targets[edge];
+					const Word				bit = Word(1) << (end % Bits);
+					boost::atomic_ref<Word>	word(visited[end / Bits]);	// Shared with the other workers.
+
+					/*
+					Look before setting: most neighbors are already reached,
+					and a plain load doesn't take the cache line away.
+					*/
+					if ((word.load(boost::memory_order_relaxed) & bit) || (word.fetch_or(bit, boost::memory_order_relaxed) & bit))
+						continue;
+					hops[end] = level + 1;
+					parents[end] = vertex;
+					mine.push_back(end);
+				}
+			}
+		return;
+	}
+
+	template<class T>
+	void BreadthFirst<T>::BottomUp(boost::atomic<int> &next, int worker)
+	{
+		const int			claim = 16;						// Words claimed at once (a thousand vertices).
+		const int			words = visited.size(),
+							count = vertices.size();
+		std::vector<int>	&mine = found[worker];			// This worker's share of the next level.
+
+		for (int first = next.fetch_add(claim); first < words; first = next.fetch_add(claim))
+			for (int word = first; word < first + claim && word < words; word++)
+			{
+				Word	reached = visited[word];	// Only this worker writes it during the step.
+
+				if (reached == ~Word(0))
+					continue;
+				for (int vertex = word * Bits; vertex < word * Bits + Bits && vertex < count; vertex++)
+				{
+					const Word	bit = Word(1) << (vertex % Bits);
+
+					if (reached & bit)
+						continue;
+					for (int edge = reverseOffsets[vertex]; edge < reverseOffsets[vertex + 1]; edge++)
+						if (frontier[sources[edge] / Bits] & (Word(1) << (sources[edge] % Bits)))
+						{
+							hops[vertex] = level + 1;
+							parents[vertex] = sources[edge];
+							reached |= bit;
+							mine.push_back(vertex);
+							break;
+						}
+				}
+				visited[word] = reached;
+			}
+		return;
+	}
+}
+
+#endif
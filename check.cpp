@@ -0,0 +1,565 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by Alex Brandt                                     *
+ *   alunduil@alunduil.com                                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; version 2 of the License.               *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful.       *
+ *   but WITHOUT ANY WARRANTY: without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc..                                       *
+ *   59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.              *
+ ***************************************************************************/
+
+/**
+@file check.cpp
+@brief Differential checks of every shortest path engine against Graph::ShortestPathTree().
+@author Alex Brandt <alunduil@alunduil.com>
+
+Usage: graphcheck [trials] [seed]
+
+Builds random Directed, Undirected, Weighted and Unweighted Graphs with
+parallel edges, self loops and deleted edges and vertices (Unweighted ones
+still hold weights other than one, which must not count), and checks that
+every engine answers as Graph::ShortestPathTree() does. The listeners
+(DynamicShortestPaths, ShortestPathCache and VersionedGraph) are checked
+again after a run of random changes. The Loader is fed malformed and
+oversized files, and GraphBuilder has to build the same Graph as inserting
+the edges one thread at a time. 'make check' runs it; it prints each
+failure and exits non-zero if there were any.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <cstdlib>
+#include <cstdio>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "graph.h"
+#include "frozengraph.h"
+#include "contractionhierarchy.h"
+#include "distancematrix.h"
+#include "deltastepping.h"
+#include "breadthfirst.h"
+#include "shortestpathcache.h"
+#include "dynamicshortestpaths.h"
+#include "versionedgraph.h"
+#include "graphbuilder.h"
+#include "snapshot.h"
+#include "loader.h"
+
+using namespace Graphs;
+using namespace std;
+
+static int					failures = 0;		//!< Checks failed so far.
+static boost::random::mt19937	engine;			//!< Drives every random choice.
+static const char			*scratch = "graphcheck.tmp";	//!< The file snapshots and loader input go in.
+
+/**
+@param passed Did the check pass?
+@param what What was checked, for the failure message.
+*/
+static void Expect(bool passed, const string &what)
+{
+	if (!passed && ++failures <= 50)
+		cerr << "FAIL: " << what << endl;
+	return;
+}
+
+/**
+@param low The smallest allowed.
+@param high The largest allowed.
+@return A number picked uniformly from low to high.
+*/
+static int Uniform(int low, int high)
+{
+	return boost::random::uniform_int_distribution<int>(low, high)(engine);
+}
+
+/**
+@brief The A* heuristic that knows nothing, which makes it Dijkstra.
+*/
+struct NoEstimate
+{
+	/**
+	@return Zero, always.
+	*/
+	int operator()(const Vertex<int> &, const Vertex<int> &) const
+	{
+		return 0;
+	}
+};
+
+/**
+@param graph The Graph.
+@param from Where the edges start.
+@param to Where the edges end.
+@return The cheapest edge from one to the other as the Graph counts it, or -1 if there is none.
+*/
+static int Cheapest(const Graph<int> &graph, const Vertex<int> &from, const Vertex<int> &to)
+{
+	int	cheapest = -1;	// The best so far.
+
+	for (Vertex<int>::EdgeIterator i = from.EdgesBegin(); i != from.EdgesEnd(); i++)
+		if (boost::get<0>(*i) == &to)
+		{
+			const int	weight = graph.IsWeighted() ? boost::get<1>(*i) : 1;
+
+			if (cheapest == -1 || weight < cheapest)
+				cheapest = weight;
+		}
+	return cheapest;
+}
+
+/**
+@param graph The Graph.
+@param path A path an engine returned.
+@param source Where it should start.
+@return Its length (Infinity if it's empty), or -1 if it isn't a path from the source.
+*/
+static int Length(const Graph<int> &graph, queue<Vertex<int>*> path, const Vertex<int> &source)
+{
+	int	length = 0;	// The length so far.
+
+	if (path.empty())
+		return Infinity;
+	if (path.front() != &source)
+		return -1;
+	for (Vertex<int> *previous = path.front(); path.pop(), !path.empty(); previous = path.front())
+	{
+		const int	weight = Cheapest(graph, *previous, *path.front());	// The edge taken.
+
+		if (weight == -1)
+			return -1;
+		length += weight;
+	}
+	return length;
+}
+
+/**
+@param graph The Graph.
+@param path A path of dense identifiers an engine returned.
+@param source Where it should start.
+@return Its length (Infinity if it's empty), or -1 if it isn't a path from the source.
+*/
+static int Length(const Graph<int> &graph, queue<int> path, const Vertex<int> &source)
+{
+	queue<Vertex<int>*>	vertices;	// The same path.
+
+	for (; !path.empty(); path.pop())
+		vertices.push(graph.VertexAt(path.front()));
+	return Length(graph, vertices, source);
+}
+
+/**
+@param label Which Graph and which engine.
+@param source The source.
+@param target The destination.
+@param expected What Graph::ShortestPathTree() says.
+@param actual What the engine says.
+*/
+static void ExpectDistance(const string &label, int source, int target, int expected, int actual)
+{
+	ostringstream	what;	// The failure message.
+
+	what << label << ": " << source << " -> " << target << " expected " << expected << " got " << actual;
+	Expect(expected == actual, what.str());
+	return;
+}
+
+/**
+@param graph The Graph to fill.
+@param vertices The vertices to insert.
+@param edges The edges to insert.
+
+Random edges, some parallel to the last and some loops, then a few edges and vertices deleted.
+*/
+static void Fill(Graph<int> &graph, int vertices, int edges)
+{
+	for (int i = 0; i < vertices; i++)
+		graph.InsertNewVertex(i);
+	for (int i = 0; i < edges; i++)
+	{
+		Vertex<int>	&from = *graph.VertexAt(Uniform(0, vertices - 1)),
+					&to = Uniform(0, 19) == 0 ? from : *graph.VertexAt(Uniform(0, vertices - 1));
+
+		graph.InsertEdge(from, to, Uniform(1, 20));
+		if (Uniform(0, 4) == 0)
+			graph.InsertEdge(from, to, Uniform(1, 20));
+	}
+	for (int i = 0; i < edges / 10; i++)
+		graph.DeleteEdge(*graph.VertexAt(Uniform(0, vertices - 1)), *graph.VertexAt(Uniform(0, vertices - 1)));
+	for (int i = 0; i < vertices / 20; i++)
+	{
+		Vertex<int>	*victim = graph.VertexAt(Uniform(vertices / 2, vertices - 1));	// Only from the second half, which holds no sources.
+
+		if (victim != NULL)
+			graph.DeleteVertex(*victim);
+	}
+	return;
+}
+
+/**
+@param graph The Graph to change.
+@param sources Vertices that mustn't be deleted.
+@param changes How many changes to make.
+
+Insert, reweight and delete edges (parallel ones included) and delete vertices.
+*/
+static void Churn(Graph<int> &graph, const vector<int> &sources, int changes)
+{
+	for (int i = 0; i < changes; i++)
+	{
+		Vertex<int>	*from = graph.VertexAt(Uniform(0, graph.IndexCount() - 1)),
+					*to = graph.VertexAt(Uniform(0, graph.IndexCount() - 1));
+
+		if (from == NULL || to == NULL)
+			continue;
+		switch (Uniform(0, 9))
+		{
+			case 0:
+			case 1:
+			case 2:
+				graph.InsertEdge(*from, *to, Uniform(1, 20));
+				break;
+			case 3:
+				graph.InsertEdge(*from, *to, Uniform(1, 20));
+				graph.InsertEdge(*from, *to, Uniform(1, 20));
+				break;
+			case 4:
+			case 5:
+			case 6:
+				graph.SetWeight(*from, *to, Uniform(1, 20));
+				break;
+			case 7:
+			case 8:
+				graph.DeleteEdge(*from, *to);
+				break;
+			default:
+				if (find(sources.begin(), sources.end(), from->Index()) == sources.end())
+					graph.DeleteVertex(*from);
+				break;
+		}
+	}
+	return;
+}
+
+/**
+@param label Which Graph.
+@param graph The Graph.
+@param sources The vertices to search from.
+@param dynamic Trees kept from every source.
+@param cache A cache of trees.
+@param versioned Versions of the Graph.
+
+Compare every engine with Graph::ShortestPathTree() from each source to every vertex.
+*/
+static void CheckEngines(const string &label, Graph<int> &graph, const vector<int> &sources, DynamicShortestPaths<int> &dynamic, ShortestPathCache<int> &cache, VersionedGraph<int> &versioned)
+{
+	ThreadPool					pool(3);			// Threads for the parallel engines.
+	FrozenGraph<int>			frozen(graph);
+	ContractionHierarchy<int>	hierarchy(graph);
+	DistanceMatrix				floyd,
+								dijkstra;
+	DeltaStepping<int>			delta(graph);
+	BreadthFirst<int>			breadthFirst(graph);
+	Snapshot<int>				snapshot;
+	SearchState					searchState,		// Scratch space for the versioned searches.
+								guided;				// Scratch space for the instrumented A* search.
+	unsigned long				queries = 0;		// Point to point queries asked of each engine.
+
+	floyd.FloydWarshall(graph, pool);
+	dijkstra.Dijkstra(graph, pool);
+	Expect(Snapshot<int>::Write(graph, scratch) && snapshot.Open(scratch), label + ": snapshot " + snapshot.Error());
+
+	for (vector<int>::const_iterator i = sources.begin(); i != sources.end(); i++)
+	{
+		const Vertex<int>			&source = *graph.VertexAt(*i);
+		const PathTree<int>			tree = graph.ShortestPathTree(source);	// The reference.
+
+		delta.Search(source, pool);
+		if (!graph.IsWeighted())
+			breadthFirst.Search(source, pool);
+		for (int j = 0; j < graph.IndexCount(); j++)
+		{
+			if (graph.VertexAt(j) == NULL)
+				continue;
+
+			const Vertex<int>	&target = *graph.VertexAt(j);
+			const int			expected = tree.Distance(target);
+
+			ExpectDistance(label + " Graph::ShortestPath", *i, j, expected, Length(graph, graph.ShortestPath(source, target), source));
+			ExpectDistance(label + " Graph::AStarShortestPath", *i, j, expected, Length(graph, graph.AStarShortestPath(source, target, NoEstimate()), source));
+			ExpectDistance(label + " Graph::BidirectionalShortestPath", *i, j, expected, Length(graph, graph.BidirectionalShortestPath(source, target), source));
+			ExpectDistance(label + " FrozenGraph::ShortestPath", *i, j, expected, Length(graph, frozen.ShortestPath(source, target), source));
+			ExpectDistance(label + " FrozenGraph::BidirectionalShortestPath", *i, j, expected, Length(graph, frozen.BidirectionalShortestPath(source, target), source));
+			ExpectDistance(label + " ContractionHierarchy", *i, j, expected, Length(graph, hierarchy.ShortestPath(source, target), source));
+			ExpectDistance(label + " DistanceMatrix::FloydWarshall", *i, j, expected, floyd.Distance(*i, j));
+			ExpectDistance(label + " DistanceMatrix::Dijkstra", *i, j, expected, dijkstra.Distance(*i, j));
+			ExpectDistance(label + " DeltaStepping", *i, j, expected, delta.Distance(target));
+			if (!graph.IsWeighted())
+				ExpectDistance(label + " BreadthFirst", *i, j, expected, breadthFirst.Hops(target));
+			ExpectDistance(label + " Snapshot", *i, j, expected, Length(graph, snapshot.ShortestPath(*i, j), source));
+			ExpectDistance(label + " ShortestPathCache", *i, j, expected, Length(graph, cache.ShortestPath(source, target), source));
+			ExpectDistance(label + " DynamicShortestPaths", *i, j, expected, dynamic.Distance(source, target));
+			ExpectDistance(label + " VersionedGraph", *i, j, expected, Length(graph, versioned.ShortestPath(0, *i, j, searchState), source));
+			queries++;
+
+			/*
+			With no estimate A* settles and relaxes exactly what Dijkstra does.
+			*/
+			if (Instrumented && graph.IsWeighted())
+			{
+				graph.ShortestPath(source, target, searchState);
+				graph.AStarShortestPath(source, target, NoEstimate(), guided);
+				ExpectDistance(label + " A* settled", *i, j, searchState.Counters().settled, guided.Counters().settled);
+				ExpectDistance(label + " A* relaxed", *i, j, searchState.Counters().relaxed, guided.Counters().relaxed);
+			}
+		}
+	}
+	if (Instrumented)
+		Expect(frozen.Stats().Queries() == 2 * queries && hierarchy.Stats().Queries() == queries && frozen.Stats().Latencies().Count() == 2 * queries, label + ": queries missing from the stats");
+	remove(scratch);
+	return;
+}
+
+/**
+@param direction Directed or Undirected.
+@param weighting Weighted or Unweighted.
+@param trial Which trial, for the failure messages.
+*/
+static void CheckGraph(Direction direction, Weighting weighting, int trial)
+{
+	Graph<int>		graph(direction, weighting);
+	ostringstream	label;		// Names the Graph in failure messages.
+	vector<int>		sources;	// The vertices searched from.
+
+	label << (direction == Directed ? "directed" : "undirected") << (weighting == Weighted ? " weighted" : " unweighted") << " trial " << trial;
+	Fill(graph, Uniform(2, 60), Uniform(0, 200));
+	for (int i = 0; i < 4; i++)
+		sources.push_back(Uniform(0, graph.IndexCount() / 2 - 1));
+
+	DynamicShortestPaths<int>	dynamic(graph);
+	ShortestPathCache<int>		cache(graph, 4);
+	VersionedGraph<int>			versioned(graph, 1);
+
+	for (vector<int>::iterator i = sources.begin(); i != sources.end(); i++)
+		dynamic.AddSource(*graph.VertexAt(*i));
+	CheckEngines(label.str(), graph, sources, dynamic, cache, versioned);
+	Churn(graph, sources, 80);
+	CheckEngines(label.str() + " after changes", graph, sources, dynamic, cache, versioned);
+	return;
+}
+
+/**
+@param trial Which trial, for the failure messages.
+
+Build the same random edges through a GraphBuilder from several threads and
+through Graph::InsertEdges(), and compare the two.
+*/
+static void CheckBuilder(int trial)
+{
+	const int					threads = 3,
+								vertices = Uniform(1, 50);
+	const Direction				direction = trial % 2 ? Undirected : Directed;
+	Graph<int>					built(direction, Weighted),
+								expected(direction, Weighted);
+	GraphBuilder<int>			builder(built, threads);
+	vector<Graph<int>::EdgeTriple>	edges;
+	ostringstream				label;	// Names the trial in failure messages.
+
+	label << "GraphBuilder trial " << trial;
+	for (int i = 0; i < vertices; i++)
+	{
+		Expect(builder.InsertVertex(i % threads, i) == i, label.str() + ": identifiers out of order");
+		expected.InsertNewVertex(i);
+	}
+	for (int i = Uniform(0, 150); i > 0; i--)
+	{
+		const Graph<int>::EdgeTriple	edge(Uniform(-1, vertices), Uniform(0, vertices - 1), Uniform(1, 20));	// Now and then naming no vertex.
+
+		builder.InsertEdge(Uniform(0, threads - 1), boost::get<0>(edge), boost::get<1>(edge), boost::get<2>(edge));
+		edges.push_back(edge);
+	}
+	builder.Finish();
+	expected.InsertEdges(edges.begin(), edges.end());
+
+	Expect(built.VertexCount() == expected.VertexCount() && built.EdgeCount() == expected.EdgeCount(), label.str() + ": counts differ");
+	for (int i = 0; i < vertices && i < built.IndexCount(); i++)
+	{
+		const PathTree<int>	want = expected.ShortestPathTree(*expected.VertexAt(i)),
+							got = built.ShortestPathTree(*built.VertexAt(i));
+
+		for (int j = 0; j < vertices; j++)
+			ExpectDistance(label.str(), i, j, want.Distance(*expected.VertexAt(j)), got.Distance(*built.VertexAt(j)));
+	}
+	return;
+}
+
+/**
+Batches naming identifiers out of range or deleted skip those edges rather than touching memory they shouldn't.
+*/
+static void CheckInsertEdges(void)
+{
+	for (int direction = 0; direction < 2; direction++)
+	{
+		Graph<int>						graph(direction ? Directed : Undirected, Weighted);
+		vector<Graph<int>::EdgeTriple>	edges;
+
+		for (int i = 0; i < 4; i++)
+			graph.InsertNewVertex(i);
+		graph.DeleteVertex(*graph.VertexAt(3));
+		edges.push_back(Graph<int>::EdgeTriple(0, 1, 5));
+		edges.push_back(Graph<int>::EdgeTriple(4, 1, 5));
+		edges.push_back(Graph<int>::EdgeTriple(1, 1000000, 5));
+		edges.push_back(Graph<int>::EdgeTriple(-1, 2, 5));
+		edges.push_back(Graph<int>::EdgeTriple(2, -7, 5));
+		edges.push_back(Graph<int>::EdgeTriple(3, 0, 5));
+		edges.push_back(Graph<int>::EdgeTriple(0, 3, 5));
+		edges.push_back(Graph<int>::EdgeTriple(1, 2, 5));
+		Expect(graph.InsertEdges(edges.begin(), edges.end()) == 2 && graph.EdgeCount() == 2 && graph.ShortestPathTree(*graph.VertexAt(0)).Distance(*graph.VertexAt(2)) == 10, "InsertEdges: bad identifiers weren't skipped");
+	}
+	return;
+}
+
+/**
+Graphs whose kind is fixed at compile time take the same choice (or none) from their constructors, and search as the run time kind does.
+*/
+static void CheckPolicies(void)
+{
+	Graph<int, Directed, Weighted>		byDirection(Directed),
+										byWeighting(Weighted),
+										byDefault;
+	Graph<int, Undirected, Unweighted>	unweighted(Undirected, Unweighted);
+	Graph<int>							expected(Directed, Weighted);
+
+	Expect(byDirection.IsDirected() && byDirection.IsWeighted() && byWeighting.IsDirected() && byWeighting.IsWeighted() && byDefault.IsDirected() && byDefault.IsWeighted(), "Graph<int, Directed, Weighted>: constructed as another kind");
+	Expect(!unweighted.IsDirected() && !unweighted.IsWeighted(), "Graph<int, Undirected, Unweighted>: constructed as another kind");
+	for (int i = 0; i < 4; i++)
+	{
+		byDefault.InsertNewVertex(i);
+		expected.InsertNewVertex(i);
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		byDefault.InsertEdge(*byDefault.VertexAt(i), *byDefault.VertexAt((i + 1) % 4), i + 1);
+		expected.InsertEdge(*expected.VertexAt(i), *expected.VertexAt((i + 1) % 4), i + 1);
+	}
+	Expect(byDefault.ShortestPath(*byDefault.VertexAt(3), *byDefault.VertexAt(2)).size() == expected.ShortestPath(*expected.VertexAt(3), *expected.VertexAt(2)).size()
+		&& byDefault.BidirectionalShortestPath(*byDefault.VertexAt(3), *byDefault.VertexAt(2)).size() == 4, "Graph<int, Directed, Weighted>: paths differ from Graph<int>");
+	return;
+}
+
+/**
+Percentiles round the rank up: the 99th of 150 times is the 149th, and the 7th of 100 the 7th.
+*/
+static void CheckPercentile(void)
+{
+	LatencyHistogram	tail,	// 148 fast times and 2 slow ones.
+						head;	// 7 fast times and 93 slow ones.
+
+	for (int i = 0; i < 150; i++)
+		tail.Record(i < 148 ? 1000 : 1000000);
+	for (int i = 0; i < 100; i++)
+		head.Record(i < 7 ? 1000 : 1000000);
+	Expect(tail.Percentile(0.99) == 1000000, "LatencyHistogram: p99 of 150 times isn't the 149th");
+	Expect(head.Percentile(0.07) < 2000, "LatencyHistogram: p7 of 100 times isn't the 7th");
+	Expect(tail.Percentile(0) < 2000 && tail.Percentile(1) == 1000000, "LatencyHistogram: p0 or p100 out of range");
+	return;
+}
+
+/**
+@param contents What goes in the file.
+@param dimacs Load it as DIMACS (or as an edge list)?
+@param loads Should it load?
+@param vertices How many vertices it should load (if it loads).
+@param edges How many edges it should load (if it loads).
+*/
+static void CheckLoad(const string &contents, bool dimacs, bool loads, int vertices = 0, int edges = 0)
+{
+	Graph<int>		graph(Directed, Weighted);
+	Loader<int>		loader(graph);
+	ofstream		out(scratch, ios::out | ios::binary | ios::trunc);
+	ostringstream	what;		// The failure message.
+	bool			loaded;
+
+	out << contents;
+	out.close();
+	loaded = dimacs ? loader.LoadDimacs(scratch) : loader.LoadEdgeList(scratch);
+	remove(scratch);
+
+	what << "Loader " << (dimacs ? "DIMACS" : "edge list") << " \"" << contents << "\": loaded " << loaded << " (" << loader.Error() << ") with " << graph.VertexCount() << " vertices and " << graph.EdgeCount() << " edges";
+	if (loads)
+		Expect(loaded && graph.VertexCount() == vertices && graph.EdgeCount() == edges, what.str());
+	else
+		Expect(!loaded && !loader.Error().empty(), what.str());
+	return;
+}
+
+/**
+Well formed, malformed and oversized input for both formats.
+*/
+static void CheckLoader(void)
+{
+	CheckLoad("# comment\n0 1 5\n1 2\n2,0,7\n\n", false, true, 3, 3);
+	CheckLoad("0 1 2147483647\n", false, true, 2, 1);
+	CheckLoad("0 1 99999999999\n", false, false);
+	CheckLoad("0 99999999999\n", false, false);
+	CheckLoad("1 2147483647\n", false, false);
+	CheckLoad("-1 2\n", false, false);
+	CheckLoad("0 1 -5\n", false, false);
+	CheckLoad("0 1 0\n", false, true, 2, 1);
+	CheckLoad("0 x\n", false, false);
+	CheckLoad("0 1 2 3\n", false, false);
+	CheckLoad("0\n", false, false);
+	CheckLoad("c comment\np sp 3 2\na 1 2 5\na 2 3 4\n", true, true, 3, 2);
+	CheckLoad("p sp 2 2000000000\na 1 2 3\n", true, true, 2, 1);
+	CheckLoad("p sp 3 2\na 1 2 5\na 2 3 99999999999\n", true, false);
+	CheckLoad("p sp 2 1\na 1 2 -5\n", true, false);
+	CheckLoad("p sp 2147483647 1\n", true, false);
+	CheckLoad("p sp 99999999999 1\n", true, false);
+	CheckLoad("a 1 2 3\n", true, false);
+	CheckLoad("p sp 2 1\na 1 3 3\n", true, false);
+	CheckLoad("p sp 2 1\np sp 2 1\n", true, false);
+	CheckLoad("p max 2 1\n", true, false);
+	CheckLoad("x\n", true, false);
+	return;
+}
+
+int main(int argc, char *argv[])
+{
+	const int	trials = argc > 1 ? atoi(argv[1]) : 25;	// Random Graphs of each kind.
+
+	engine.seed(argc > 2 ? atoi(argv[2]) : 1);
+	for (int i = 0; i < trials; i++)
+	{
+		CheckGraph(Directed, Weighted, i);
+		CheckGraph(Directed, Unweighted, i);
+		CheckGraph(Undirected, Weighted, i);
+		CheckGraph(Undirected, Unweighted, i);
+		CheckBuilder(i);
+	}
+	CheckInsertEdges();
+	CheckPolicies();
+	CheckPercentile();
+	CheckLoader();
+
+	if (failures > 0)
+	{
+		cerr << failures << " checks failed" << endl;
+		return 1;
+	}
+	cout << "all checks passed" << endl;
+	return 0;
+}
@@ -0,0 +1,543 @@
+//
+// C++ Interface: contractionhierarchy
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHCONTRACTIONHIERARCHY_H
+#define GRAPHCONTRACTIONHIERARCHY_H
+
+#include <vector>
+#include <list>
+#include <queue>
+#include <functional>
+#include <utility>
+
+#include "graph.h"
+#include "searchstate.h"
+#include "stats.h"
+
+namespace Graphs
+{
+	/**
+	@class ContractionHierarchy contractionhierarchy.h
+	@brief Preprocessed Graph answering point to point queries by searching upward only.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Vertices are contracted one at a time, least important first. Contracting
+	a vertex takes it out of the graph and adds a shortcut u -> x for every
+	pair of its remaining neighbors whose shortest path ran through it (a
+	bounded witness search looks for another way around). A vertex's rank is
+	when it was contracted. Importance is the number of shortcuts contraction
+	would add less the edges it would remove, plus the neighbors already
+	contracted, so that contraction spreads evenly over the graph.
+
+	Every edge and shortcut ends up stored once, with the lower ranked of its
+	two vertices: edges leaving it in its upward row, edges coming into it in
+	its downward row. A query runs Dijkstra's algorithm upward from the source
+	and, over the downward rows, upward from the target; the shortest path
+	peaks at the highest ranked vertex on it, where the two searches meet.
+	Shortcuts remember the two arcs they stand for, so the path is unpacked
+	back into the Graph's vertices.
+
+	The hierarchy is a snapshot: it doesn't see later changes to the Graph,
+	and the Graph must outlive it since paths are handed back as its vertices.
+	Weights must not be negative.
+	*/
+	template<class T>
+	class ContractionHierarchy
+	{
+		public:
+			/**
+			@param graph The Graph to preprocess.
+
+			Constructor
+			*/
+			explicit ContractionHierarchy(const Graph<T> &graph);
+
+			/**
+			@return The number of vertex identifiers covered.
+			*/
+			int VertexCount(void) const;
+
+			/**
+			@return The number of arcs in the hierarchy (edges and shortcuts).
+			*/
+			int ArcCount(void) const;
+
+			/**
+			@return The number of shortcuts added by contraction.
+			*/
+			int ShortcutCount(void) const;
+
+			/**
+			@param vertex The dense identifier of the vertex.
+			@return When the vertex was contracted (0 for the first).
+			*/
+			int Rank(int vertex) const;
+
+			/**
+			@param vertexA The source vertex.
+			@param vertexB The destination vertex.
+			@return A queue that is the path to follow.
+
+			Shortest path from one node to another through the hierarchy, unpacked into the Graph's vertices.
+			*/
+			std::queue<Vertex<T>*> ShortestPath(const Vertex<T> &vertexA, const Vertex<T> &vertexB);
+
+			/**
+			@return The work and time of every query so far (all zero unless Instrumented).
+			*/
+			const GraphStats &Stats(void) const;
+
+			/**
+			Start the Stats() counting again from zero.
+			*/
+			void ResetStats(void);
+
+		private:
+			static const int	WitnessLimit = 500;	//!< Vertices a witness search may settle before giving up.
+
+			/**
+			@brief An edge or shortcut of the finished hierarchy.
+			*/
+			struct Arc
+			{
+				int	from;	//!< Where the arc starts.
+				int	to;		//!< Where the arc ends.
+				int	weight;	//!< The length of the arc.
+				int	first;	//!< For a shortcut, the arc from "from" to the contracted vertex (-1 for an edge).
+				int	second;	//!< For a shortcut, the arc from the contracted vertex to "to".
+			};
+
+			/**
+			@brief An edge or shortcut between two vertices not yet contracted.
+			*/
+			struct Link
+			{
+				int	other;	//!< The vertex at the other end.
+				int	weight;	//!< The length of the link.
+				int	first;	//!< As for Arc.
+				int	second;	//!< As for Arc.
+			};
+
+			typedef std::vector<std::vector<Link> >	Links;	//!< Links by vertex identifier.
+
+			std::vector<Arc>		arcs;			//!< Every arc, grouped by the lower ranked vertex in contraction order.
+			std::vector<int>		upBegin;		//!< Where each vertex's upward row starts in arcs.
+			std::vector<int>		downBegin;		//!< Where each vertex's downward row starts (and its upward row ends).
+			std::vector<int>		downEnd;		//!< Where each vertex's downward row ends.
+			std::vector<int>		ranks;			//!< When each vertex was contracted.
+			std::vector<Vertex<T>*>	vertices;		//!< The Graph's vertices by dense identifier.
+			int						shortcuts;		//!< The number of shortcuts added.
+			SearchState				forward;		//!< Scratch space for the search from the source.
+			SearchState				backward;		//!< Scratch space for the search from the target.
+			GraphStats				stats;			//!< The work and time of every query.
+
+			/**
+			@param outgoing The links leaving each vertex.
+			@param incoming The links coming into each vertex.
+			@param from Where the link starts.
+			@param link The link to add (or shorten).
+			*/
+			static void Connect(Links &outgoing, Links &incoming, int from, const Link &link);
+
+			/**
+			@param links The links of a vertex.
+			@param other The vertex to unlink.
+			*/
+			static void Disconnect(std::vector<Link> &links, int other);
+
+			/**
+			@param outgoing The links leaving each vertex.
+			@param incoming The links coming into each vertex.
+			@param contracted How many of each vertex's neighbors have been contracted.
+			@param witness Scratch space for the witness searches.
+			@param vertex The vertex to contract.
+			@param simulate True to only count the shortcuts.
+			@return The number of shortcuts contraction adds.
+			*/
+			int Contract(Links &outgoing, Links &incoming, std::vector<int> &contracted, SearchState &witness, int vertex, bool simulate);
+
+			/**
+			@param outgoing The links leaving each vertex.
+			@param incoming The links coming into each vertex.
+			@param contracted How many of each vertex's neighbors have been contracted.
+			@param witness Scratch space for the witness searches.
+			@param vertex The vertex not yet contracted.
+			@return How bad an idea contracting it now is.
+			*/
+			int Priority(Links &outgoing, Links &incoming, std::vector<int> &contracted, SearchState &witness, int vertex);
+
+			/**
+			@param arc The arc to unpack.
+			@param path Where the vertices after the arc's start go.
+			*/
+			void Unpack(int arc, std::list<Vertex<T>*> &path) const;
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			ContractionHierarchy(const ContractionHierarchy &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			ContractionHierarchy &operator=(const ContractionHierarchy &);
+	};
+
+	template<class T>
+	ContractionHierarchy<T>::ContractionHierarchy(const Graph<T> &graph)
+	:arcs(std::vector<Arc>()), upBegin(std::vector<int>(graph.IndexCount())), downBegin(std::vector<int>(graph.IndexCount())), downEnd(std::vector<int>(graph.IndexCount())), ranks(std::vector<int>(graph.IndexCount())), vertices(std::vector<Vertex<T>*>()), shortcuts(0), forward(SearchState()), backward(SearchState()), stats()
+	{
+		using namespace std;
+
+		typedef pair<int, int>	Candidate;	// Priority and vertex identifier.
+
+		const int			count = graph.IndexCount();		// Vertex identifiers to contract.
+		Links				outgoing(count),				// Links leaving each vertex.
+							incoming(count);				// Links coming into each vertex.
+		vector<int>			contracted(count, 0);			// Neighbors of each vertex contracted so far.
+		SearchState			witness;						// Scratch space for the witness searches.
+		priority_queue<Candidate, vector<Candidate>, greater<Candidate> >	candidates;	// Vertices by priority (lazily updated).
+		int					rank = 0;						// The next rank to hand out.
+
+		/*
+		Start from the Graph's own edges, keeping the shortest of any parallel ones.
+		*/
+		vertices.reserve(count);
+		for (int i = 0; i < count; i++)
+		{
+			Vertex<T>	*vertex = graph.VertexAt(i);	// NULL for deleted identifiers.
+
+			vertices.push_back(vertex);
+			if (vertex == NULL)
+				continue;
+			for (typename Vertex<T>::EdgeIterator j = vertex->EdgesBegin(); j != vertex->EdgesEnd(); j++)
+			{
+				const Link	link = { boost::get<0>(*j)->Index(), graph.IsWeighted() ? boost::get<1>(*j) : 1, -1, -1 };	// The edge (one hop if Unweighted).
+
+				if (link.other != i)
+					Connect(outgoing, incoming, i, link);
+			}
+		}
+
+		witness.Reset(count);
+		for (int i = 0; i < count; i++)
+			candidates.push(Candidate(Priority(outgoing, incoming, contracted, witness, i), i));
+
+		/*
+		Contract the least important vertex, checking its priority first since
+		contracting its neighbors may have changed it.
+		*/
+		arcs.reserve(graph.EdgeCount() * 2);
+		while (!candidates.empty())
+		{
+			const int	vertex = candidates.top().second;	// The candidate.
+			int			priority;						// Its current priority.
+
+			candidates.pop();
+			priority = Priority(outgoing, incoming, contracted, witness, vertex);
+			if (!candidates.empty() && priority > candidates.top().first)
+			{
+				candidates.push(Candidate(priority, vertex));
+				continue;
+			}
+			ranks[vertex] = rank++;
+			shortcuts += Contract(outgoing, incoming, contracted, witness, vertex, false);
+		}
+	}
+
+	template<class T>
+	int ContractionHierarchy<T>::VertexCount(void) const
+	{
+		return vertices.size();
+	}
+
+	template<class T>
+	int ContractionHierarchy<T>::ArcCount(void) const
+	{
+		return arcs.size();
+	}
+
+	template<class T>
+	int ContractionHierarchy<T>::ShortcutCount(void) const
+	{
+		return shortcuts;
+	}
+
+	template<class T>
+	int ContractionHierarchy<T>::Rank(int vertex) const
+	{
+		return ranks[vertex];
+	}
+
+	template<class T>
+	std::queue<Vertex<T>*> ContractionHierarchy<T>::ShortestPath(const Vertex<T> &vertexA, const Vertex<T> &vertexB)
+	{
+		using namespace std;
+
+		const int				source = vertexA.Index(),	// Where we start.
+								target = vertexB.Index();	// Where we're going.
+		list<int>				arcPath;					// The hierarchy's arcs from source to target.
+		list<Vertex<T>*>		shortestPathList;			// The found shortest path.
+		queue<Vertex<T>*>		shortestPath;				// The found shortest path (clean).
+		int						best = Infinity,			// Length of the shortest path seen so far.
+								meeting = -1;				// Where that path peaks.
+		QueryTimer				timer(stats, forward, &backward);	// Counts the query when it returns.
+
+		/*
+		Parents are arc numbers rather than vertices, so that shortcuts can be unpacked.
+		*/
+		forward.Reset(vertices.size());
+		backward.Reset(vertices.size());
+		forward.Improve(source, 0, -1);
+		backward.Improve(target, 0, -1);
+
+		/*
+		The searches can't stop at the first meeting since they run in
+		different graphs; each goes on until its frontier is no nearer than
+		the best path.
+		*/
+		while (forward.FrontierMinimum() < best || backward.FrontierMinimum() < best)
+		{
+			const bool	outward = forward.FrontierMinimum() <= backward.FrontierMinimum();	// Growing the forward search?
+			SearchState	&near = outward ? forward : backward,		// The search being grown.
+						&far = outward ? backward : forward;		// The other one.
+			const int	current = near.Settle();					// The vertex being settled.
+
+			if (current == -1)
+				continue;
+
+			const int	currentDistance = near.Distance(current);	// Final in this search.
+			bool		stalled = false;							// Is there a shorter way here from above?
+
+			if (far.Distance(current) != Infinity && currentDistance + far.Distance(current) < best)
+			{
+				best = currentDistance + far.Distance(current);
+				meeting = current;
+			}
+
+			/*
+			Stall on demand: if a higher vertex already reached reaches this
+			one more cheaply, no shortest path leads up through it.
+			*/
+			for (int i = outward ? downBegin[current] : upBegin[current]; !stalled && i < (outward ? downEnd[current] : downBegin[current]); i++)
+			{
+				const int	above = outward ? arcs[i].from : arcs[i].to;	// The higher end of the arc.
+
+				stalled = near.Distance(above) != Infinity && near.Distance(above) + arcs[i].weight < currentDistance;
+			}
+			if (stalled)
+				continue;
+
+			for (int i = outward ? upBegin[current] : downBegin[current]; i < (outward ? downBegin[current] : downEnd[current]); i++)
+				near.Improve(outward ? arcs[i].to : arcs[i].from, currentDistance + arcs[i].weight, i);
+		}
+
+		if (meeting == -1)
+			return shortestPath;
+
+		/*
+		Collect the arcs up from the source and down to the target, then unpack them.
+		*/
+		for (int i = forward.Parent(meeting); i != -1; i = forward.Parent(arcs[i].from))
+			arcPath.push_front(i);
+		for (int i = backward.Parent(meeting); i != -1; i = backward.Parent(arcs[i].to))
+			arcPath.push_back(i);
+		shortestPathList.push_back(vertices[source]);
+		for (list<int>::iterator i = arcPath.begin(); i != arcPath.end(); i++)
+			Unpack(*i, shortestPathList);
+		for (typename list<Vertex<T>*>::iterator i = shortestPathList.begin(); i != shortestPathList.end(); i++)
+			shortestPath.push(*i);
+		return shortestPath;
+	}
+
+	template<class T>
+	void ContractionHierarchy<T>::Connect(Links &outgoing, Links &incoming, int from, const Link &link)
+	{
+		std::vector<Link>	&links = outgoing[from];	// The links leaving from.
+
+		for (typename std::vector<Link>::iterator i = links.begin(); i != links.end(); i++)
+			if (i->other == link.other)
+			{
+				if (link.weight < i->weight)
+				{
+					std::vector<Link>	&back = incoming[link.other];	// The links coming into the other end.
+
+					*i = link;
+					for (typename std::vector<Link>::iterator j = back.begin(); j != back.end(); j++)
+						if (j->other == from)
+						{
+							*j = link;
+							j->other = from;
+						}
+				}
+				return;
+			}
+
+		Link	reverse = link;	// The same link seen from the other end.
+
+		reverse.other = from;
+		links.push_back(link);
+		incoming[link.other].push_back(reverse);
+		return;
+	}
+
+	template<class T>
+	void ContractionHierarchy<T>::Disconnect(std::vector<Link> &links, int other)
+	{
+		for (typename std::vector<Link>::iterator i = links.begin(); i != links.end(); i++)
+			if (i->other == other)
+			{
+				*i = links.back();
+				links.pop_back();
+				return;
+			}
+		return;
+	}
+
+	template<class T>
+	int ContractionHierarchy<T>::Contract(Links &outgoing, Links &incoming, std::vector<int> &contracted, SearchState &witness, int vertex, bool simulate)
+	{
+		const std::vector<Link>	&out = outgoing[vertex],	// Links to higher vertices.
+								&in = incoming[vertex];		// Links from higher vertices.
+		std::vector<int>		up,							// The arc each outgoing link became.
+								down;						// The arc each incoming link became.
+		int						added = 0,					// Shortcuts needed.
+								longest = 0;				// The longest outgoing link.
+
+		/*
+		Whatever links are left go to vertices contracted later, so they're this vertex's rows.
+		*/
+		if (!simulate)
+		{
+			upBegin[vertex] = arcs.size();
+			for (typename std::vector<Link>::const_iterator i = out.begin(); i != out.end(); i++)
+			{
+				const Arc	arc = { vertex, i->other, i->weight, i->first, i->second };	// The upward arc.
+
+				up.push_back(arcs.size());
+				arcs.push_back(arc);
+			}
+			downBegin[vertex] = arcs.size();
+			for (typename std::vector<Link>::const_iterator i = in.begin(); i != in.end(); i++)
+			{
+				const Arc	arc = { i->other, vertex, i->weight, i->first, i->second };	// The downward arc.
+
+				down.push_back(arcs.size());
+				arcs.push_back(arc);
+			}
+			downEnd[vertex] = arcs.size();
+		}
+
+		for (typename std::vector<Link>::const_iterator i = out.begin(); i != out.end(); i++)
+			if (i->weight > longest)
+				longest = i->weight;
+
+		/*
+		For each way in, look for a path to each way out that avoids this vertex
+		and is no longer than going through it; where there isn't one, shortcut.
+		*/
+		for (std::size_t i = 0; i < in.size(); i++)
+		{
+			const int	from = in[i].other,				// Where the way in starts.
+						limit = in[i].weight + longest;	// No witness longer than this is any use.
+			int			settledCount = 0;				// Vertices the witness search has settled.
+
+			witness.Reset(outgoing.size());
+			witness.Improve(from, 0, -1);
+			for (int current = witness.Settle(); current != -1 && witness.Distance(current) <= limit && settledCount++ < WitnessLimit; current = witness.Settle())
+				if (current != vertex)
+					for (typename std::vector<Link>::const_iterator j = outgoing[current].begin(); j != outgoing[current].end(); j++)
+						witness.Improve(j->other, witness.Distance(current) + j->weight, current);
+
+			for (std::size_t j = 0; j < out.size(); j++)
+			{
+				const int	through = in[i].weight + out[j].weight;	// The length of the path through this vertex.
+
+				if (out[j].other == from || witness.Distance(out[j].other) <= through)
+					continue;
+				added++;
+				if (!simulate)
+				{
+					const Link	shortcut = { out[j].other, through, down[i], up[j] };	// Stands in for the two arcs.
+
+					Connect(outgoing, incoming, from, shortcut);
+				}
+			}
+		}
+
+		/*
+		Take the vertex out of what's left of the graph.
+		*/
+		if (!simulate)
+		{
+			for (typename std::vector<Link>::const_iterator i = out.begin(); i != out.end(); i++)
+			{
+				Disconnect(incoming[i->other], vertex);
+				contracted[i->other]++;
+			}
+			for (typename std::vector<Link>::const_iterator i = in.begin(); i != in.end(); i++)
+			{
+				Disconnect(outgoing[i->other], vertex);
+				contracted[i->other]++;
+			}
+			outgoing[vertex].clear();
+			incoming[vertex].clear();
+		}
+		return added;
+	}
+
+	template<class T>
+	int ContractionHierarchy<T>::Priority(Links &outgoing, Links &incoming, std::vector<int> &contracted, SearchState &witness, int vertex)
+	{
+		const int	removed = outgoing[vertex].size() + incoming[vertex].size();	// Links contraction takes away.
+
+		return Contract(outgoing, incoming, contracted, witness, vertex, true) - removed + contracted[vertex];
+	}
+
+	template<class T>
+	const GraphStats &ContractionHierarchy<T>::Stats(void) const
+	{
+		return stats;
+	}
+
+	template<class T>
+	void ContractionHierarchy<T>::ResetStats(void)
+	{
+		stats.Reset();
+		return;
+	}
+
+	template<class T>
+	void ContractionHierarchy<T>::Unpack(int arc, std::list<Vertex<T>*> &path) const
+	{
+		std::vector<int>	pending(1, arc);	// Arcs still to unpack, the next one last.
+
+		/*
+		A shortcut is replaced by its two halves; an edge adds its end to the path.
+		*/
+		while (!pending.empty())
+		{
+			const Arc	&current = arcs[pending.back()];	// The arc being unpacked.
+
+			pending.pop_back();
+			if (current.first == -1)
+				path.push_back(vertices[current.to]);
+			else
+			{
+				pending.push_back(current.second);
+				pending.push_back(current.first);
+			}
+		}
+		return;
+	}
+}
+
+#endif
@@ -0,0 +1,338 @@
+//
+// C++ Interface: deltastepping
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHDELTASTEPPING_H
+#define GRAPHDELTASTEPPING_H
+
+#include <vector>
+#include <algorithm>
+#include <boost/atomic.hpp>
+#include <boost/atomic/atomic_ref.hpp>
+#include <boost/bind/bind.hpp>
+
+#include "graph.h"
+#include "threadpool.h"
+
+namespace Graphs
+{
+	/**
+	@class DeltaStepping deltastepping.h
+	@brief Parallel shortest distances from one source to every vertex.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Delta-stepping (Meyer and Sanders) trades Dijkstra's strict one vertex at
+	a time order for buckets of width delta: every vertex in the lowest
+	bucket is expanded at once, by all the workers of a ThreadPool. Light
+	edges (weight at most delta) can land back in the same bucket, so they
+	are relaxed over and over until the bucket stays empty; heavy edges
+	can't, so they are relaxed once, for everything the bucket held, just
+	before moving on. Distances are lowered with an atomic compare and swap,
+	and each worker files the vertices it improves in buckets of its own.
+
+	A small delta does little wasted work but has few vertices per bucket to
+	share out; a large one the reverse, tending to Bellman-Ford. Left to
+	itself, delta is the heaviest weight over the average degree.
+
+	Like FrozenGraph, the adjacency is copied into compressed sparse rows
+	(light edges first in each row) when the engine is built, and later
+	changes to the Graph aren't seen. Weights must not be negative.
+	*/
+	template<class T>
+	class DeltaStepping
+	{
+		public:
+			/**
+			@param graph The Graph to search.
+			@param delta The bucket width (0 to pick one from the weights).
+
+			Constructor
+			*/
+			explicit DeltaStepping(const Graph<T> &graph, int delta = 0);
+
+			/**
+			@return The bucket width.
+			*/
+			int Delta(void) const;
+
+			/**
+			@param source The source vertex.
+			@param pool The threads to search with.
+
+			Find the distance from the source to every vertex.
+			*/
+			void Search(const Vertex<T> &source, ThreadPool &pool);
+
+			/**
+			@param vertex A vertex of the Graph.
+			@return Its distance from the last Search()'s source, or Infinity if it can't be reached.
+			*/
+			int Distance(const Vertex<T> &vertex) const;
+
+			/**
+			@return The distances from the last Search()'s source by dense identifier.
+			*/
+			const std::vector<int> &Distances(void) const;
+
+		private:
+			typedef std::vector<std::vector<int> >	Buckets;	//!< Vertex identifiers by bucket slot.
+
+			std::vector<int>			offsets;	//!< Where each vertex's edges start.
+			std::vector<int>			splits;		//!< Where each vertex's heavy edges start.
+			std::vector<int>			targets;	//!< The end of each edge.
+			std::vector<int>			weights;	//!< The weight of each edge.
+			int							delta;		//!< The bucket width.
+			int							slots;		//!< Buckets kept at once (cyclically reused).
+			std::vector<int>			distances;	//!< Tentative distances by dense identifier.
+			std::vector<Buckets>		buckets;	//!< Each worker's buckets.
+			std::vector<int>			frontier;	//!< The vertices being expanded.
+			std::vector<int>			settled;	//!< Everything expanded from the current bucket.
+			std::vector<unsigned int>	gathered;	//!< The pass that last put each vertex on the frontier.
+			std::vector<unsigned int>	expanded;	//!< The bucket (plus one) that last expanded each vertex.
+
+			/**
+			@param bucket The bucket to collect.
+			@param pass Stamp for this pass, to keep duplicates off the frontier.
+
+			Move the live entries of a bucket from every worker on to the frontier.
+			*/
+			void Gather(int bucket, unsigned int pass);
+
+			/**
+			@param bucket The bucket just finished.
+			@return The next bucket holding anything, or -1 if they're all empty.
+			*/
+			int NextBucket(int bucket) const;
+
+			/**
+			@param vertex The vertex to improve.
+			@param candidate Its candidate distance.
+			@param worker The worker's number.
+			*/
+			void Relax(int vertex, int candidate, int worker);
+
+			/**
+			@param next The next frontier entry to claim.
+			@param worker The worker's number.
+
+			A worker: relax the light edges leaving the frontier.
+			*/
+			void RelaxLight(boost::atomic<int> &next, int worker);
+
+			/**
+			@param next The next settled entry to claim.
+			@param worker The worker's number.
+
+			A worker: relax the heavy edges leaving everything the bucket held.
+			*/
+			void RelaxHeavy(boost::atomic<int> &next, int worker);
+	};
+
+	template<class T>
+	DeltaStepping<T>::DeltaStepping(const Graph<T> &graph, int delta)
+	:offsets(std::vector<int>()), splits(std::vector<int>()), targets(std::vector<int>()), weights(std::vector<int>()), delta(delta), slots(0), distances(std::vector<int>()), buckets(std::vector<Buckets>()), frontier(std::vector<int>()), settled(std::vector<int>()), gathered(std::vector<unsigned int>()), expanded(std::vector<unsigned int>())
+	{
+		int	heaviest = 0,	// The largest weight.
+			edges = 0;		// Total adjacency entries.
+
+		for (int i = 0; i < graph.IndexCount(); i++)
+			if (graph.VertexAt(i) != NULL)
+				for (typename Vertex<T>::EdgeIterator j = graph.VertexAt(i)->EdgesBegin(); j != graph.VertexAt(i)->EdgesEnd(); j++, edges++)
+					heaviest = std::max(heaviest, graph.IsWeighted() ? boost::get<1>(*j) : 1);
+		if (this->delta <= 0)
+			this->delta = std::max(1, heaviest / std::max(1, edges / std::max(1, graph.VertexCount())));
+
+		/*
+		Tentative distances are never more than the heaviest weight past the
+		current bucket, so this many slots never wrap on to a live one.
+		*/
+		slots = heaviest / this->delta + 2;
+
+		offsets.reserve(graph.IndexCount() + 1);
+		splits.reserve(graph.IndexCount());
+		targets.reserve(edges);
+		weights.reserve(edges);
+		offsets.push_back(0);
+		for (int i = 0; i < graph.IndexCount(); i++)
+		{
+			Vertex<T>	*vertex = graph.VertexAt(i);	// NULL for deleted identifiers, which keep an empty row.
+
+			for (int heavy = 0; heavy < 2; heavy++)
+			{
+				if (heavy)
+					splits.push_back(targets.size());
+				if (vertex != NULL)
+					for (typename Vertex<T>::EdgeIterator j = vertex->EdgesBegin(); j != vertex->EdgesEnd(); j++)
+					{
+						const int	weight = graph.IsWeighted() ? boost::get<1>(*j) : 1;	// What the edge counts for.
+
+						if ((weight > this->delta) == (heavy == 1))
+						{
+							targets.push_back(boost::get<0>(*j)->Index());
+							weights.push_back(weight);
+						}
+					}
+			}
+			offsets.push_back(targets.size());
+		}
+	}
+
+	template<class T>
+	int DeltaStepping<T>::Delta(void) const
+	{
+		return delta;
+	}
+
+	template<class T>
+	void DeltaStepping<T>::Search(const Vertex<T> &source, ThreadPool &pool)
+	{
+		const int		count = splits.size();	// Vertex identifiers.
+		unsigned int	pass = 0;				// Frontier passes so far.
+
+		distances.assign(count, Infinity);
+		gathered.assign(count, 0);
+		expanded.assign(count, 0);
+		buckets.assign(pool.Size(), Buckets(slots));
+		if (source.Index() < 0 || source.Index() >= count)
+			return;
+
+		distances[source.Index()] = 0;
+		buckets[0][0].push_back(source.Index());
+
+		for (int bucket = 0; bucket != -1; bucket = NextBucket(bucket))
+		{
+			boost::atomic<int>	next(0);	// The next entry to claim.
+
+			/*
+			Light edges can refill the bucket, so keep at it until it stays empty.
+			*/
+			settled.clear();
+			for (Gather(bucket, ++pass); !frontier.empty(); Gather(bucket, ++pass))
+			{
+				for (std::vector<int>::iterator i = frontier.begin(); i != frontier.end(); i++)
+					if (expanded[*i] != static_cast<unsigned int>(bucket) + 1)
+					{
+						expanded[*i] = bucket + 1;
+						settled.push_back(*i);
+					}
+				next = 0;
+				pool.Run(boost::bind(&DeltaStepping<T>::RelaxLight, this, boost::ref(next), boost::placeholders::_1));
+			}
+
+			next = 0;
+			pool.Run(boost::bind(&DeltaStepping<T>::RelaxHeavy, this, boost::ref(next), boost::placeholders::_1));
+		}
+		return;
+	}
+
+	template<class T>
+	int DeltaStepping<T>::Distance(const Vertex<T> &vertex) const
+	{
+		if (vertex.Index() < 0 || vertex.Index() >= static_cast<int>(distances.size()))
+			return Infinity;
+		return distances[vertex.Index()];
+	}
+
+	template<class T>
+	const std::vector<int> &DeltaStepping<T>::Distances(void) const
+	{
+		return distances;
+	}
+
+	template<class T>
+	void DeltaStepping<T>::Gather(int bucket, unsigned int pass)
+	{
+		const int	slot = bucket % slots;	// Where the bucket lives.
+
+		/*
+		Entries whose vertex has since moved to a lower bucket are stale.
+		*/
+		frontier.clear();
+		for (typename std::vector<Buckets>::iterator i = buckets.begin(); i != buckets.end(); i++)
+		{
+			std::vector<int>	&entries = (*i)[slot];	// This worker's share of the bucket.
+
+			for (std::vector<int>::iterator j = entries.begin(); j != entries.end(); j++)
+				if (distances[*j] / delta == bucket && gathered[*j] != pass)
+				{
+					gathered[*j] = pass;
+					frontier.push_back(*j);
+				}
+			entries.clear();
+		}
+		return;
+	}
+
+	template<class T>
+	int DeltaStepping<T>::NextBucket(int bucket) const
+	{
+		for (int i = 1; i < slots; i++)
+			for (typename std::vector<Buckets>::const_iterator j = buckets.begin(); j != buckets.end(); j++)
+				if (!(*j)[(bucket + i) % slots].empty())
+					return bucket + i;
+		return -1;
+	}
+
+	template<class T>
+	void DeltaStepping<T>::Relax(int vertex, int candidate, int worker)
+	{
+		boost::atomic_ref<int>	distance(distances[vertex]);		// Shared with the other workers.
+		int						current = distance.load(boost::memory_order_relaxed);
+
+		/*
+		Atomic minimum: retry until we either win or someone else got lower.
+		*/
+		while (candidate < current)
+			if (distance.compare_exchange_weak(current, candidate, boost::memory_order_relaxed))
+			{
+				buckets[worker][candidate / delta % slots].push_back(vertex);
+				return;
+			}
+		return;
+	}
+
+	template<class T>
+	void DeltaStepping<T>::RelaxLight(boost::atomic<int> &next, int worker)
+	{
+		const int	claim = 64;					// Frontier entries claimed at once.
+		const int	size = frontier.size();
+
+		for (int first = next.fetch_add(claim); first < size; first = next.fetch_add(claim))
+			for (int i = first; i < first + claim && i < size; i++)
+			{
+				const int	vertex = frontier[i],
+							distance = boost::atomic_ref<int>(distances[vertex]).load(boost::memory_order_relaxed);
+
+				for (int edge = offsets[vertex]; edge < splits[vertex]; edge++)
+					Relax(targets[edge], distance + weights[edge], worker);
+			}
+		return;
+	}
+
+	template<class T>
+	void DeltaStepping<T>::RelaxHeavy(boost::atomic<int> &next, int worker)
+	{
+		const int	claim = 64;					// Settled entries claimed at once.
+		const int	size = settled.size();
+
+		for (int first = next.fetch_add(claim); first < size; first = next.fetch_add(claim))
+			for (int i = first; i < first + claim && i < size; i++)
+			{
+				const int	vertex = settled[i],
+							distance = distances[vertex];	// Final, and nobody writes it during this phase.
+
+				for (int edge = splits[vertex]; edge < offsets[vertex + 1]; edge++)
+					Relax(targets[edge], distance + weights[edge], worker);
+			}
+		return;
+	}
+}
+
+#endif
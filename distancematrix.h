@@ -0,0 +1,324 @@
+//
+// C++ Interface: distancematrix
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHDISTANCEMATRIX_H
+#define GRAPHDISTANCEMATRIX_H
+
+#include <vector>
+#include <algorithm>
+#include <boost/atomic.hpp>
+#include <boost/bind/bind.hpp>
+
+#include "graph.h"
+#include "searchstate.h"
+#include "threadpool.h"
+
+namespace Graphs
+{
+	/**
+	@class DistanceMatrix distancematrix.h
+	@brief Shortest distances between every pair of vertices.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	The distances are kept row-major in one block of memory: the distance
+	from vertex i to vertex j is entry i * Size() + j, where i and j are
+	dense identifiers. Unreachable pairs (and deleted identifiers) hold
+	Infinity. Two ways of filling it are offered, both spread over a
+	ThreadPool:
+
+	FloydWarshall() works in square tiles small enough to stay in cache,
+	each round updating the tile on the diagonal, then its row and column,
+	then everything else. Its cost is V^3 whatever the edges, so it suits
+	dense graphs of up to some thousands of vertices.
+
+	Dijkstra() runs a full Dijkstra's search from every vertex, one row per
+	search. Its cost is about V * E log V, so it suits sparse graphs.
+
+	Weights must not be negative, and no distance may reach Infinity / 2.
+	*/
+	class DistanceMatrix
+	{
+		public:
+			/**
+			Constructor
+			*/
+			DistanceMatrix(void);
+
+			/**
+			@return The number of rows (and columns).
+			*/
+			int Size(void) const;
+
+			/**
+			@param from The dense identifier of the source.
+			@param to The dense identifier of the destination.
+			@return The shortest distance from one to the other, or Infinity.
+			*/
+			int Distance(int from, int to) const;
+
+			/**
+			@param from The dense identifier of the source.
+			@return The distances from the source to every vertex, Size() of them.
+			*/
+			const int *Row(int from) const;
+
+			/**
+			@param graph The Graph to measure.
+			@param pool The threads to measure it with.
+
+			Fill the matrix with blocked Floyd-Warshall.
+			*/
+			template<class T>
+			void FloydWarshall(const Graph<T> &graph, ThreadPool &pool);
+
+			/**
+			@param graph The Graph to measure.
+			@param pool The threads to measure it with.
+
+			Fill the matrix with a Dijkstra's search from every vertex.
+			*/
+			template<class T>
+			void Dijkstra(const Graph<T> &graph, ThreadPool &pool);
+
+		private:
+			static const int	Tile = 64;					//!< Tiles are Tile x Tile entries (16KiB of ints).
+			static const int	Unreachable = Infinity / 2;	//!< Stands in for Infinity while Floyd-Warshall runs, so sums can't overflow.
+
+			int					size;		//!< The number of rows (and columns).
+			std::vector<int>	distances;	//!< The matrix, row-major.
+
+			/**
+			@param rowTile The tile row being updated.
+			@param columnTile The tile column being updated.
+			@param round The tile row and column of the intermediate vertices.
+
+			Shorten every path in a tile through the round's intermediate vertices.
+			*/
+			void RelaxTile(int rowTile, int columnTile, int round);
+
+			/**
+			@param round The tile row and column of the intermediate vertices.
+			@param next The next tile to claim.
+			@param worker The worker's number (unused).
+
+			A Floyd-Warshall worker: relax the round's row and column tiles.
+			*/
+			void RelaxCross(int round, boost::atomic<int> &next, int worker);
+
+			/**
+			@param round The tile row and column of the intermediate vertices.
+			@param next The next tile to claim.
+			@param worker The worker's number (unused).
+
+			A Floyd-Warshall worker: relax the tiles off the round's row and column.
+			*/
+			void RelaxRest(int round, boost::atomic<int> &next, int worker);
+
+			/**
+			@param graph The Graph being measured.
+			@param states Scratch space for each worker.
+			@param next The next source to claim.
+			@param worker The worker's number.
+
+			A Dijkstra() worker: claim sources one at a time and fill in their rows.
+			*/
+			template<class T>
+			void SearchFrom(const Graph<T> &graph, std::vector<SearchState> &states, boost::atomic<int> &next, int worker);
+	};
+
+	inline DistanceMatrix::DistanceMatrix(void)
+	:size(0), distances(std::vector<int>())
+	{
+	}
+
+	inline int DistanceMatrix::Size(void) const
+	{
+		return size;
+	}
+
+	inline int DistanceMatrix::Distance(int from, int to) const
+	{
+		return distances[static_cast<std::size_t>(from) * size + to];
+	}
+
+	inline const int *DistanceMatrix::Row(int from) const
+	{
+		return &distances[static_cast<std::size_t>(from) * size];
+	}
+
+	template<class T>
+	void DistanceMatrix::FloydWarshall(const Graph<T> &graph, ThreadPool &pool)
+	{
+		size = graph.IndexCount();
+		distances.assign(static_cast<std::size_t>(size) * size, static_cast<int>(Unreachable));
+
+		/*
+		Start from the edges themselves, keeping the shortest of any parallel ones.
+		*/
+		for (int i = 0; i < size; i++)
+		{
+			const Vertex<T>	*vertex = graph.VertexAt(i);	// NULL for deleted identifiers.
+			int				*row = &distances[static_cast<std::size_t>(i) * size];
+
+			if (vertex == NULL)
+				continue;
+			row[i] = 0;
+			for (typename Vertex<T>::EdgeIterator j = vertex->EdgesBegin(); j != vertex->EdgesEnd(); j++)
+				row[boost::get<0>(*j)->Index()] = std::min(row[boost::get<0>(*j)->Index()], graph.IsWeighted() ? boost::get<1>(*j) : 1);
+		}
+
+		/*
+		Each round's diagonal tile has to be done before its row and column,
+		and those before the rest; every Run() waits for its workers to finish.
+		*/
+		for (int round = 0; round * Tile < size; round++)
+		{
+			boost::atomic<int>	next(0);	// The next tile to claim.
+
+			RelaxTile(round, round, round);
+			pool.Run(boost::bind(&DistanceMatrix::RelaxCross, this, round, boost::ref(next), boost::placeholders::_1));
+			next = 0;
+			pool.Run(boost::bind(&DistanceMatrix::RelaxRest, this, round, boost::ref(next), boost::placeholders::_1));
+		}
+
+		for (std::vector<int>::iterator i = distances.begin(); i != distances.end(); i++)
+			if (*i >= Unreachable)
+				*i = Infinity;
+		return;
+	}
+
+	template<class T>
+	void DistanceMatrix::Dijkstra(const Graph<T> &graph, ThreadPool &pool)
+	{
+		std::vector<SearchState>	states(pool.Size());	// Scratch space for each worker.
+		boost::atomic<int>			next(0);				// The next source to claim.
+
+		size = graph.IndexCount();
+		distances.assign(static_cast<std::size_t>(size) * size, Infinity);
+		pool.Run(boost::bind(&DistanceMatrix::SearchFrom<T>, this, boost::cref(graph), boost::ref(states), boost::ref(next), boost::placeholders::_1));
+		return;
+	}
+
+	inline void DistanceMatrix::RelaxTile(int rowTile, int columnTile, int round)
+	{
+		const int	rowBegin = rowTile * Tile,
+					rowEnd = std::min(rowBegin + Tile, size),
+					columnBegin = columnTile * Tile,
+					width = std::min(columnBegin + Tile, size) - columnBegin,
+					middleBegin = round * Tile,
+					middleEnd = std::min(middleBegin + Tile, size);
+
+		/*
+		The inner loop runs along contiguous rows with no branches, so the
+		compiler turns it into vector minimums. It will only do that at -O2
+		when the trip count is fixed and nothing can overlap, hence the copy
+		of row k and the separate loop for full tiles.
+		*/
+		for (int k = middleBegin; k < middleEnd; k++)
+		{
+			const int	*from = &distances[static_cast<std::size_t>(k) * size + columnBegin];	// Distances on from k.
+			int			through[Tile];															// A copy of them.
+
+			std::copy(from, from + width, through);
+
+			for (int i = rowBegin; i < rowEnd; i++)
+			{
+				int			*row = &distances[static_cast<std::size_t>(i) * size];	// Distances from i.
+				const int	toMiddle = row[k];										// Distance from i to k.
+
+				if (toMiddle >= Unreachable)
+					continue;
+				row += columnBegin;
+				if (width == Tile)
+					for (int j = 0; j < Tile; j++)
+						row[j] = std::min(row[j], toMiddle + through[j]);
+				else
+					for (int j = 0; j < width; j++)
+						row[j] = std::min(row[j], toMiddle + through[j]);
+			}
+		}
+		return;
+	}
+
+	inline void DistanceMatrix::RelaxCross(int round, boost::atomic<int> &next, int)
+	{
+		const int	tiles = (size + Tile - 1) / Tile;	// Tiles along each side.
+
+		/*
+		Claims below tiles are the round's row, the rest its column.
+		*/
+		for (int claim = next++; claim < 2 * tiles; claim = next++)
+		{
+			const int	other = claim % tiles;	// The tile column (or row) off the diagonal.
+
+			if (other == round)
+				continue;
+			if (claim < tiles)
+				RelaxTile(round, other, round);
+			else
+				RelaxTile(other, round, round);
+		}
+		return;
+	}
+
+	inline void DistanceMatrix::RelaxRest(int round, boost::atomic<int> &next, int)
+	{
+		const int	tiles = (size + Tile - 1) / Tile;	// Tiles along each side.
+
+		for (int claim = next++; claim < tiles * tiles; claim = next++)
+		{
+			const int	rowTile = claim / tiles,
+						columnTile = claim % tiles;
+
+			if (rowTile != round && columnTile != round)
+				RelaxTile(rowTile, columnTile, round);
+		}
+		return;
+	}
+
+	template<class T>
+	void DistanceMatrix::SearchFrom(const Graph<T> &graph, std::vector<SearchState> &states, boost::atomic<int> &next, int worker)
+	{
+		SearchState	&searchState = states[worker];	// This worker's scratch space.
+
+		for (int source = next++; source < size; source = next++)
+		{
+			int	*row = &distances[static_cast<std::size_t>(source) * size];	// The source's distances.
+
+			if (graph.VertexAt(source) == NULL)
+				continue;
+
+			/*
+			Dijkstra's Algorithm (or a breadth first search), run until everything reachable is settled.
+			*/
+			searchState.Reset(size);
+			if (!graph.IsWeighted())
+			{
+				searchState.Discover(source, -1);
+				for (int current = searchState.Next(); current != -1; current = searchState.Next())
+				{
+					graph.VertexAt(current)->ForEachEdge(Discovery<T>(searchState, current));
+					row[current] = searchState.Distance(current);
+				}
+				continue;
+			}
+			searchState.Improve(source, 0, -1);
+			for (int current = searchState.Settle(); current != -1; current = searchState.Settle())
+			{
+				graph.VertexAt(current)->ForEachEdge(Relaxation<T>(searchState, current));
+				row[current] = searchState.Distance(current);
+			}
+		}
+		return;
+	}
+}
+
+#endif
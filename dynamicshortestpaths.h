@@ -0,0 +1,557 @@
+//
+// C++ Interface: dynamicshortestpaths
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHDYNAMICSHORTESTPATHS_H
+#define GRAPHDYNAMICSHORTESTPATHS_H
+
+#include <vector>
+#include <list>
+#include <queue>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <boost/unordered_map.hpp>
+
+#include "graph.h"
+#include "graphlistener.h"
+
+namespace Graphs
+{
+	/**
+	@class DynamicShortestPaths dynamicshortestpaths.h
+	@brief Shortest path trees from registered sources, repaired as the Graph changes.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Where ShortestPathCache throws its trees away on every change, this
+	keeps one tree per registered source and mends it in place, after
+	Ramalingam and Reps. It listens to the Graph, so InsertEdge(),
+	DeleteEdge(), SetWeight() and the rest are all it takes.
+
+	An edge that gets cheaper (or is inserted) can only shorten paths, so
+	the vertices it improves are searched outward from its end, Dijkstra
+	style, and the search stops where nothing improves. An edge on the tree
+	that gets dearer (or is deleted) can only lengthen paths through it:
+	its subtree is walked in order of distance, and every vertex that still
+	has an equally short way in from outside keeps its distance under a new
+	parent, cutting the walk short there. Only the rest lose their
+	distances; they are seeded from their other incoming edges and settled
+	by a search confined to them. Changes off the tree, and increases on
+	vertices with a way around, cost next to nothing. Either way the work
+	is proportional to the vertices whose distance changes and their edges,
+	not to the Graph.
+
+	The edges into each vertex come from the Graph (InEdgesBegin()). Weights
+	must not be negative, and are counted as one each if the Graph is
+	Unweighted (as its own searches do).
+	*/
+	template<class T>
+	class DynamicShortestPaths : public GraphListener<T>
+	{
+		public:
+			/**
+			@param graph The Graph to keep paths on.
+
+			Constructor
+			*/
+			explicit DynamicShortestPaths(Graph<T> &graph);
+
+			/**
+			Destructor
+			*/
+			~DynamicShortestPaths(void);
+
+			/**
+			@param source The vertex to keep a tree from (searched for now, unless it already has one).
+			*/
+			void AddSource(const Vertex<T> &source);
+
+			/**
+			@param source The vertex to stop keeping a tree from.
+			*/
+			void RemoveSource(const Vertex<T> &source);
+
+			/**
+			@param source A vertex of the Graph.
+			@return True if a tree is kept from it.
+			*/
+			bool IsSource(const Vertex<T> &source) const;
+
+			/**
+			@param source A registered source.
+			@param vertex A vertex of the Graph.
+			@return The distance from the source, or Infinity if it can't be reached (or the source isn't registered).
+			*/
+			int Distance(const Vertex<T> &source, const Vertex<T> &vertex) const;
+
+			/**
+			@param source A registered source.
+			@param vertex A vertex of the Graph.
+			@return The vertex before it on the shortest path, or NULL for the source and unreachable vertices.
+			*/
+			Vertex<T> * Parent(const Vertex<T> &source, const Vertex<T> &vertex) const;
+
+			/**
+			@param source A registered source.
+			@param vertex The destination vertex.
+			@return A queue that is the path to follow (empty if the destination can't be reached).
+			*/
+			std::queue<Vertex<T>*> ShortestPath(const Vertex<T> &source, const Vertex<T> &vertex) const;
+
+			/**
+			@return The vertices the last change made us look at, over every tree.
+			*/
+			int Work(void) const;
+
+			/**
+			@param vertex The vertex that was just inserted.
+			*/
+			void VertexInserted(Vertex<T> &vertex);
+
+			/**
+			@param vertex The vertex about to be deleted.
+			*/
+			void VertexDeleted(const Vertex<T> &vertex);
+
+			/**
+			@param from Where the new edge starts.
+			@param to Where the new edge ends.
+			@param weight The weight of the new edge.
+			*/
+			void EdgeInserted(Vertex<T> &from, Vertex<T> &to, int weight);
+
+			/**
+			@param from Where the deleted edges started.
+			@param to Where the deleted edges ended.
+			*/
+			void EdgeDeleted(Vertex<T> &from, Vertex<T> &to);
+
+			/**
+			@param from Where the edge starts.
+			@param to Where the edge ends.
+			@param oldWeight The weight the first of the edges had (unused, since parallel edges may differ).
+			@param newWeight The weight it has now.
+			*/
+			void WeightChanged(Vertex<T> &from, Vertex<T> &to, int oldWeight, int newWeight);
+
+		private:
+			typedef std::pair<int, int>	HeapEntry;	//!< Distance and the vertex identifier it belongs to.
+
+			/**
+			@brief The shortest path tree from one source.
+			*/
+			struct Tree
+			{
+				std::vector<int>	distances;	//!< Distances from the source by dense identifier.
+				std::vector<int>	parents;	//!< Parents by dense identifier (-1 for none).
+
+				/**
+				Constructor
+				*/
+				Tree(void);
+			};
+
+			Graph<T>							&graph;		//!< The Graph being watched.
+			boost::unordered_map<int, Tree>		trees;		//!< The trees by source.
+			std::vector<unsigned int>			marks;		//!< The repair that last found each vertex affected.
+			unsigned int						stamp;		//!< The current repair.
+			std::vector<HeapEntry>				heap;		//!< Min-heap of vertices to look at (lazy deletion).
+			std::vector<int>					affected;	//!< The vertices whose distance the repair has to find again.
+			int									deleted;	//!< The vertex being deleted (-1 if none).
+			int									work;		//!< The vertices looked at since the last change.
+
+			/**
+			@param weight The weight of an edge.
+			@return What it counts for (one if the Graph is Unweighted).
+			*/
+			int Weight(int weight) const;
+
+			/**
+			@param distance The vertex's distance.
+			@param vertex The vertex identifier.
+			*/
+			void Push(int distance, int vertex);
+
+			/**
+			@return The vertex identifier and distance at the top of the heap, which is popped.
+			*/
+			HeapEntry Pop(void);
+
+			/**
+			@param tree The tree to mend.
+
+			Settle everything on the heap and whatever it improves, Dijkstra style.
+			*/
+			void Propagate(Tree &tree);
+
+			/**
+			@param tree The tree to mend.
+			@param from Where the edge starts.
+			@param to Where the edge ends.
+			@param weight Its new weight.
+
+			An edge got cheaper or was inserted.
+			*/
+			void Decrease(Tree &tree, int from, int to, int weight);
+
+			/**
+			@param tree The tree to mend.
+			@param root The end of the tree edge that got dearer or was deleted.
+
+			Everything below root might be further away now.
+			*/
+			void Increase(Tree &tree, int root);
+
+			/**
+			@param tree The tree being mended.
+			@param vertex A vertex whose parent is affected.
+			@return True if it has another parent, unaffected and as close, which it now uses.
+			*/
+			bool Reparent(Tree &tree, int vertex);
+
+			/**
+			@param from Where the edge starts.
+			@param to Where the edge ends.
+			@param weight The weight of the edge.
+			@param decreased Might the edge have got cheaper, or is it new?
+			@param increased Might it have got dearer, or is it gone?
+
+			Mend every tree after a change to the edges from one vertex to another.
+			*/
+			void Update(int from, int to, int weight, bool decreased, bool increased);
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			DynamicShortestPaths(const DynamicShortestPaths &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			DynamicShortestPaths &operator=(const DynamicShortestPaths &);
+	};
+
+	template<class T>
+	DynamicShortestPaths<T>::Tree::Tree(void)
+	:distances(std::vector<int>()), parents(std::vector<int>())
+	{
+	}
+
+	template<class T>
+	DynamicShortestPaths<T>::DynamicShortestPaths(Graph<T> &graph)
+	:GraphListener<T>(), graph(graph), trees(boost::unordered_map<int, Tree>()), marks(std::vector<unsigned int>(graph.IndexCount(), 0)), stamp(0), heap(std::vector<HeapEntry>()), affected(std::vector<int>()), deleted(-1), work(0)
+	{
+		graph.Attach(*this);
+	}
+
+	template<class T>
+	DynamicShortestPaths<T>::~DynamicShortestPaths(void)
+	{
+		graph.Detach(*this);
+	}
+
+	template<class T>
+	void DynamicShortestPaths<T>::AddSource(const Vertex<T> &source)
+	{
+		if (trees.find(source.Index()) != trees.end())
+			return;
+
+		Tree	&tree = trees[source.Index()];	// The new tree.
+
+		tree.distances.assign(graph.IndexCount(), Infinity);
+		tree.parents.assign(graph.IndexCount(), -1);
+		work = 0;
+		heap.clear();
+		tree.distances[source.Index()] = 0;
+		Push(0, source.Index());
+		Propagate(tree);
+		return;
+	}
+
+	template<class T>
+	void DynamicShortestPaths<T>::RemoveSource(const Vertex<T> &source)
+	{
+		trees.erase(source.Index());
+		return;
+	}
+
+	template<class T>
+	bool DynamicShortestPaths<T>::IsSource(const Vertex<T> &source) const
+	{
+		return trees.find(source.Index()) != trees.end();
+	}
+
+	template<class T>
+	int DynamicShortestPaths<T>::Distance(const Vertex<T> &source, const Vertex<T> &vertex) const
+	{
+		typename boost::unordered_map<int, Tree>::const_iterator	found = trees.find(source.Index());
+
+		if (found == trees.end() || vertex.Index() < 0 || vertex.Index() >= static_cast<int>(found->second.distances.size()))
+			return Infinity;
+		return found->second.distances[vertex.Index()];
+	}
+
+	template<class T>
+	Vertex<T> * DynamicShortestPaths<T>::Parent(const Vertex<T> &source, const Vertex<T> &vertex) const
+	{
+		typename boost::unordered_map<int, Tree>::const_iterator	found = trees.find(source.Index());
+
+		if (found == trees.end() || vertex.Index() < 0 || vertex.Index() >= static_cast<int>(found->second.parents.size()) || found->second.parents[vertex.Index()] == -1)
+			return NULL;
+		return graph.VertexAt(found->second.parents[vertex.Index()]);
+	}
+
+	template<class T>
+	std::queue<Vertex<T>*> DynamicShortestPaths<T>::ShortestPath(const Vertex<T> &source, const Vertex<T> &vertex) const
+	{
+		using namespace std;
+
+		list<Vertex<T>*>		shortestPathList;	// The found shortest path.
+		queue<Vertex<T>*>		shortestPath;		// The found shortest path (clean).
+
+		if (Distance(source, vertex) == Infinity)
+			return shortestPath;
+
+		const Tree	&tree = trees.find(source.Index())->second;	// The source's tree.
+
+		for (int i = vertex.Index(); i != -1; i = tree.parents[i])
+			shortestPathList.push_front(graph.VertexAt(i));
+		for (typename list<Vertex<T>*>::iterator i = shortestPathList.begin(); i != shortestPathList.end(); i++)
+			shortestPath.push(*i);
+		return shortestPath;
+	}
+
+	template<class T>
+	int DynamicShortestPaths<T>::Work(void) const
+	{
+		return work;
+	}
+
+	template<class T>
+	void DynamicShortestPaths<T>::VertexInserted(Vertex<T> &)
+	{
+		/*
+		Nothing reaches a new vertex yet, so making room is all there is to do.
+		*/
+		marks.resize(graph.IndexCount(), 0);
+		for (typename boost::unordered_map<int, Tree>::iterator i = trees.begin(); i != trees.end(); i++)
+		{
+			i->second.distances.resize(graph.IndexCount(), Infinity);
+			i->second.parents.resize(graph.IndexCount(), -1);
+		}
+		return;
+	}
+
+	template<class T>
+	void DynamicShortestPaths<T>::VertexDeleted(const Vertex<T> &vertex)
+	{
+		/*
+		The vertex still has its edges while we're told, so it's kept out of
+		the repair by hand; afterwards the Graph has no edges to or from it.
+		*/
+		work = 0;
+		deleted = vertex.Index();
+		trees.erase(deleted);
+		for (typename boost::unordered_map<int, Tree>::iterator i = trees.begin(); i != trees.end(); i++)
+			if (i->second.distances[deleted] != Infinity)
+				Increase(i->second, deleted);
+		deleted = -1;
+		return;
+	}
+
+	template<class T>
+	void DynamicShortestPaths<T>::EdgeInserted(Vertex<T> &from, Vertex<T> &to, int weight)
+	{
+		work = 0;
+		Update(from.Index(), to.Index(), Weight(weight), true, false);
+		if (!graph.IsDirected())
+			Update(to.Index(), from.Index(), Weight(weight), true, false);
+		return;
+	}
+
+	template<class T>
+	void DynamicShortestPaths<T>::EdgeDeleted(Vertex<T> &from, Vertex<T> &to)
+	{
+		work = 0;
+		Update(from.Index(), to.Index(), Infinity, false, true);
+		if (!graph.IsDirected())
+			Update(to.Index(), from.Index(), Infinity, false, true);
+		return;
+	}
+
+	template<class T>
+	void DynamicShortestPaths<T>::WeightChanged(Vertex<T> &from, Vertex<T> &to, int, int newWeight)
+	{
+		/*
+		Graph::SetWeight() sets every parallel edge but reports the old
+		weight of the first, which needn't be the one a tree uses. So
+		rather than trust it, a tree through the edges is always mended
+		as if they got dearer, then as if they got cheaper.
+		*/
+		work = 0;
+		Update(from.Index(), to.Index(), Weight(newWeight), true, true);
+		if (!graph.IsDirected())
+			Update(to.Index(), from.Index(), Weight(newWeight), true, true);
+		return;
+	}
+
+	template<class T>
+	int DynamicShortestPaths<T>::Weight(int weight) const
+	{
+		return graph.IsWeighted() ? weight : 1;
+	}
+
+	template<class T>
+	void DynamicShortestPaths<T>::Push(int distance, int vertex)
+	{
+		heap.push_back(HeapEntry(distance, vertex));
+		std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+		return;
+	}
+
+	template<class T>
+	typename DynamicShortestPaths<T>::HeapEntry DynamicShortestPaths<T>::Pop(void)
+	{
+		HeapEntry	top = heap.front();	// The closest entry.
+
+		std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+		heap.pop_back();
+		return top;
+	}
+
+	template<class T>
+	void DynamicShortestPaths<T>::Propagate(Tree &tree)
+	{
+		while (!heap.empty())
+		{
+			const HeapEntry	top = Pop();		// The closest vertex left.
+			const int		vertex = top.second;
+
+			if (top.first != tree.distances[vertex])
+				continue;
+			work++;
+			for (typename Vertex<T>::EdgeIterator i = graph.VertexAt(vertex)->EdgesBegin(); i != graph.VertexAt(vertex)->EdgesEnd(); i++)
+			{
+				const int	end = boost::get<0>(*i)->Index(),
+							candidate = top.first + Weight(boost::get<1>(*i));
+
+				if (end != deleted && candidate < tree.distances[end])
+				{
+					tree.distances[end] = candidate;
+					tree.parents[end] = vertex;
+					Push(candidate, end);
+				}
+			}
+		}
+		return;
+	}
+
+	template<class T>
+	void DynamicShortestPaths<T>::Decrease(Tree &tree, int from, int to, int weight)
+	{
+		if (tree.distances[from] == Infinity || tree.distances[from] + weight >= tree.distances[to])
+			return;
+		heap.clear();
+		tree.distances[to] = tree.distances[from] + weight;
+		tree.parents[to] = from;
+		Push(tree.distances[to], to);
+		Propagate(tree);
+		return;
+	}
+
+	template<class T>
+	void DynamicShortestPaths<T>::Increase(Tree &tree, int root)
+	{
+		/*
+		Walk the subtree in order of distance. With no zero weight edges, a
+		vertex's other way in has to come from something closer, which has
+		already been found affected or not, so the check is final.
+		*/
+		stamp++;
+		heap.clear();
+		affected.clear();
+		Push(tree.distances[root], root);
+		while (!heap.empty())
+		{
+			const int	vertex = Pop().second;	// The closest vertex left.
+
+			if (marks[vertex] == stamp || (vertex != deleted && Reparent(tree, vertex)))
+				continue;
+			work++;
+			marks[vertex] = stamp;
+			affected.push_back(vertex);
+			for (typename Vertex<T>::EdgeIterator i = graph.VertexAt(vertex)->EdgesBegin(); i != graph.VertexAt(vertex)->EdgesEnd(); i++)
+				if (tree.parents[boost::get<0>(*i)->Index()] == vertex && marks[boost::get<0>(*i)->Index()] != stamp)
+					Push(tree.distances[boost::get<0>(*i)->Index()], boost::get<0>(*i)->Index());
+		}
+
+		/*
+		Start the affected vertices from their best edge in from outside,
+		then let them settle among themselves.
+		*/
+		for (std::vector<int>::iterator i = affected.begin(); i != affected.end(); i++)
+		{
+			tree.distances[*i] = Infinity;
+			tree.parents[*i] = -1;
+		}
+		for (std::vector<int>::iterator i = affected.begin(); i != affected.end(); i++)
+		{
+			if (*i == deleted)
+				continue;
+			for (typename Vertex<T>::EdgeIterator j = graph.InEdgesBegin(*graph.VertexAt(*i)); j != graph.InEdgesEnd(*graph.VertexAt(*i)); j++)
+			{
+				const int	start = boost::get<0>(*j)->Index(),
+							weight = Weight(boost::get<1>(*j));
+
+				if (marks[start] != stamp && tree.distances[start] != Infinity && tree.distances[start] + weight < tree.distances[*i])
+				{
+					tree.distances[*i] = tree.distances[start] + weight;
+					tree.parents[*i] = start;
+				}
+			}
+			if (tree.distances[*i] != Infinity)
+				Push(tree.distances[*i], *i);
+		}
+		Propagate(tree);
+		return;
+	}
+
+	template<class T>
+	bool DynamicShortestPaths<T>::Reparent(Tree &tree, int vertex)
+	{
+		for (typename Vertex<T>::EdgeIterator i = graph.InEdgesBegin(*graph.VertexAt(vertex)); i != graph.InEdgesEnd(*graph.VertexAt(vertex)); i++)
+		{
+			const int	start = boost::get<0>(*i)->Index(),
+						weight = Weight(boost::get<1>(*i));
+
+			if (weight > 0 && start != deleted && marks[start] != stamp && tree.distances[start] != Infinity && tree.distances[start] + weight == tree.distances[vertex])
+			{
+				tree.parents[vertex] = start;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	template<class T>
+	void DynamicShortestPaths<T>::Update(int from, int to, int weight, bool decreased, bool increased)
+	{
+		for (typename boost::unordered_map<int, Tree>::iterator i = trees.begin(); i != trees.end(); i++)
+		{
+			if (increased && i->second.parents[to] == from)
+				Increase(i->second, to);
+			if (decreased)
+				Decrease(i->second, from, to, weight);
+		}
+		return;
+	}
+}
+
+#endif
@@ -0,0 +1,283 @@
+//
+// C++ Interface: frozengraph
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef FROZENGRAPH_H
+#define FROZENGRAPH_H
+
+#include <vector>
+#include <list>
+#include <queue>
+
+#include "graph.h"
+#include "searchstate.h"
+#include "stats.h"
+
+namespace Graphs
+{
+	/**
+	@class FrozenGraph frozengraph.h
+	@brief Read-only snapshot of a Graph laid out for fast traversal.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	The adjacency is compacted into compressed sparse rows: the edges leaving
+	vertex i are targets[offsets[i]] through targets[offsets[i + 1] - 1], with
+	the matching weights alongside. The same edges are also kept transposed,
+	grouped by the vertex they go to, for searches that run backwards from a
+	target. Vertices keep the dense identifiers the Graph gave them. The snapshot doesn't see later changes to the Graph, and
+	the Graph must outlive it since paths are handed back as its vertices.
+	*/
+	template<class T>
+	class FrozenGraph
+	{
+		public:
+			/**
+			@param graph The Graph to take a snapshot of.
+
+			Constructor
+			*/
+			explicit FrozenGraph(const Graph<T> &graph);
+
+			/**
+			@return The number of vertices.
+			*/
+			int VertexCount(void) const;
+
+			/**
+			@return The number of adjacency entries.
+			*/
+			int EdgeCount(void) const;
+
+			/**
+			@param vertex The dense identifier of the vertex.
+			@return The offset of the vertex's first edge.
+
+			The edges of vertex run from EdgesBegin(vertex) up to EdgesBegin(vertex + 1).
+			*/
+			int EdgesBegin(int vertex) const;
+
+			/**
+			@param edge The offset of the edge.
+			@return The dense identifier of the vertex the edge goes to.
+			*/
+			int Target(int edge) const;
+
+			/**
+			@param edge The offset of the edge.
+			@return The weight of the edge (1 for every edge of an Unweighted Graph).
+			*/
+			int Weight(int edge) const;
+
+			/**
+			@param vertexA The source vertex.
+			@param vertexB The destination vertex.
+			@return A queue that is the path to follow.
+
+			Dijkstra's shortest path from one node to another, run over the compacted arrays.
+			*/
+			std::queue<Vertex<T>*> ShortestPath(const Vertex<T> &vertexA, const Vertex<T> &vertexB);
+
+			/**
+			@param vertexA The source vertex.
+			@param vertexB The destination vertex.
+			@return A queue that is the path to follow.
+
+			Dijkstra's shortest path grown from both ends at once, forward from vertexA and
+			backward from vertexB over the transposed rows, until the two searches meet.
+			Each search covers roughly the ball of half the path's length, so far fewer
+			vertices are settled than by ShortestPath() on large, spread out graphs.
+			*/
+			std::queue<Vertex<T>*> BidirectionalShortestPath(const Vertex<T> &vertexA, const Vertex<T> &vertexB);
+
+			/**
+			@return The work and time of every query so far (all zero unless Instrumented).
+			*/
+			const GraphStats &Stats(void) const;
+
+			/**
+			Start the Stats() counting again from zero.
+			*/
+			void ResetStats(void);
+
+		private:
+			std::vector<int>		offsets;		//!< Where each vertex's edges start (one extra entry closes the last row).
+			std::vector<int>		targets;		//!< The end of each edge.
+			std::vector<int>		weights;		//!< The weight of each edge.
+			std::vector<int>		reverseOffsets;	//!< Where each vertex's incoming edges start.
+			std::vector<int>		sources;		//!< The start of each incoming edge.
+			std::vector<int>		reverseWeights;	//!< The weight of each incoming edge.
+			std::vector<Vertex<T>*>	vertices;		//!< The Graph's vertices by dense identifier.
+			SearchState				searchState;	//!< Scratch space reused by every ShortestPath().
+			SearchState				backwardState;	//!< Scratch space for the backward half of BidirectionalShortestPath().
+			GraphStats				stats;			//!< The work and time of every query.
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			FrozenGraph(const FrozenGraph &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			FrozenGraph &operator=(const FrozenGraph &);
+	};
+
+	template<class T>
+	FrozenGraph<T>::FrozenGraph(const Graph<T> &graph)
+	:offsets(std::vector<int>()), targets(std::vector<int>()), weights(std::vector<int>()), reverseOffsets(std::vector<int>()), sources(std::vector<int>()), reverseWeights(std::vector<int>()), vertices(std::vector<Vertex<T>*>()), searchState(SearchState()), backwardState(SearchState()), stats()
+	{
+		int	edges = 0;	// Total adjacency entries, so the rows are allocated once.
+
+		for (int i = 0; i < graph.IndexCount(); i++)
+			if (graph.VertexAt(i) != NULL)
+				edges += graph.VertexAt(i)->Degree();
+		offsets.reserve(graph.IndexCount() + 1);
+		targets.reserve(edges);
+		weights.reserve(edges);
+		vertices.reserve(graph.IndexCount());
+
+		offsets.push_back(0);
+		for (int i = 0; i < graph.IndexCount(); i++)
+		{
+			Vertex<T>	*vertex = graph.VertexAt(i);	// NULL for deleted identifiers, which keep an empty row.
+
+			if (vertex != NULL)
+				for (typename Vertex<T>::EdgeIterator j = vertex->EdgesBegin(); j != vertex->EdgesEnd(); j++)
+				{
+					targets.push_back(boost::get<0>(*j)->Index());
+					weights.push_back(graph.IsWeighted() ? boost::get<1>(*j) : 1);
+				}
+			offsets.push_back(targets.size());
+			vertices.push_back(vertex);
+		}
+
+		/*
+		Transpose the rows: count the edges into each vertex, turn the counts
+		into offsets, then drop every edge into its target's row.
+		*/
+		reverseOffsets.assign(vertices.size() + 1, 0);
+		sources.resize(targets.size());
+		reverseWeights.resize(targets.size());
+		for (std::size_t i = 0; i < targets.size(); i++)
+			reverseOffsets[targets[i] + 1]++;
+		for (std::size_t i = 1; i < reverseOffsets.size(); i++)
+			reverseOffsets[i] += reverseOffsets[i - 1];
+
+		std::vector<int>	fill(reverseOffsets.begin(), reverseOffsets.end() - 1);	// The next free slot in each reverse row.
+
+		for (int i = 0; i < static_cast<int>(vertices.size()); i++)
+			for (int j = offsets[i]; j < offsets[i + 1]; j++)
+			{
+				sources[fill[targets[j]]] = i;
+				reverseWeights[fill[targets[j]]++] = weights[j];
+			}
+	}
+
+	template<class T>
+	int FrozenGraph<T>::VertexCount(void) const
+	{
+		return vertices.size();
+	}
+
+	template<class T>
+	int FrozenGraph<T>::EdgeCount(void) const
+	{
+		return targets.size();
+	}
+
+	template<class T>
+	int FrozenGraph<T>::EdgesBegin(int vertex) const
+	{
+		return offsets[vertex];
+	}
+
+	template<class T>
+	int FrozenGraph<T>::Target(int edge) const
+	{
+		return targets[edge];
+	}
+
+	template<class T>
+	int FrozenGraph<T>::Weight(int edge) const
+	{
+		return weights[edge];
+	}
+
+	template<class T>
+	std::queue<Vertex<T>*> FrozenGraph<T>::ShortestPath(const Vertex<T> &vertexA, const Vertex<T> &vertexB)
+	{
+		using namespace std;
+
+		const int				source = vertexA.Index(),	// Where we start.
+								target = vertexB.Index();	// Where we're going.
+		list<Vertex<T>*>		shortestPathList;			// The found shortest path.
+		queue<Vertex<T>*>		shortestPath;				// The found shortest path (clean).
+		QueryTimer				timer(stats, searchState);	// Counts the query when it returns.
+
+		searchState.Reset(vertices.size());
+
+		/*
+		Walk the parents back from the target; an unreached target yields an empty path.
+		*/
+		if (!SearchRows<int>(searchState, &offsets[0], targets.empty() ? NULL : &targets[0], weights.empty() ? NULL : &weights[0], source, target))
+			return shortestPath;
+		for (int i = target; i != -1; i = searchState.Parent(i))
+			shortestPathList.push_front(vertices[i]);
+		for (typename list<Vertex<T>*>::iterator i = shortestPathList.begin(); i != shortestPathList.end(); i++)
+			shortestPath.push(*i);
+		return shortestPath;
+	}
+
+	template<class T>
+	std::queue<Vertex<T>*> FrozenGraph<T>::BidirectionalShortestPath(const Vertex<T> &vertexA, const Vertex<T> &vertexB)
+	{
+		using namespace std;
+
+		list<Vertex<T>*>		shortestPathList;	// The found shortest path.
+		queue<Vertex<T>*>		shortestPath;		// The found shortest path (clean).
+		int						meeting;			// Where the two searches met.
+		QueryTimer				timer(stats, searchState, &backwardState);	// Counts the query when it returns.
+
+		searchState.Reset(vertices.size());
+		backwardState.Reset(vertices.size());
+		meeting = SearchRowsBidirectional<int>(searchState, backwardState,
+			&offsets[0], targets.empty() ? NULL : &targets[0], weights.empty() ? NULL : &weights[0],
+			&reverseOffsets[0], sources.empty() ? NULL : &sources[0], reverseWeights.empty() ? NULL : &reverseWeights[0],
+			vertexA.Index(), vertexB.Index());
+		if (meeting == -1)
+			return shortestPath;
+
+		/*
+		The forward parents lead back to the source, the backward ones on to the target.
+		*/
+		for (int i = meeting; i != -1; i = searchState.Parent(i))
+			shortestPathList.push_front(vertices[i]);
+		for (int i = backwardState.Parent(meeting); i != -1; i = backwardState.Parent(i))
+			shortestPathList.push_back(vertices[i]);
+		for (typename list<Vertex<T>*>::iterator i = shortestPathList.begin(); i != shortestPathList.end(); i++)
+			shortestPath.push(*i);
+		return shortestPath;
+	}
+
+	template<class T>
+	const GraphStats &FrozenGraph<T>::Stats(void) const
+	{
+		return stats;
+	}
+
+	template<class T>
+	void FrozenGraph<T>::ResetStats(void)
+	{
+		stats.Reset();
+		return;
+	}
+}
+
+#endif
@@ -0,0 +1,280 @@
+//
+// C++ Interface: generator
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHGENERATOR_H
+#define GRAPHGENERATOR_H
+
+#include <vector>
+#include <cmath>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+#include "graph.h"
+
+namespace Graphs
+{
+	/**
+	@class Generator generator.h
+	@brief Fills a Graph with synthetic vertices and edges for benchmarking.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Every generator inserts new vertices (each constructed from its number,
+	counting from zero, so T must be constructible from an int like for the
+	Loader) and hands the edges to Graph::InsertEdges() in one batch. The
+	same seed always gives the same Graph.
+
+	Grid() and Road() lay vertices out on a lattice and join neighbors both
+	ways; ErdosRenyi() and RMat() draw arcs, which an Undirected Graph
+	mirrors as usual.
+	*/
+	template<class T>
+	class Generator
+	{
+		public:
+			/**
+			@param graph The Graph to fill.
+			@param seed Where the random numbers start.
+
+			Constructor
+			*/
+			explicit Generator(Graph<T> &graph, unsigned int seed = 1);
+
+			/**
+			@param rows The rows of the lattice.
+			@param columns The columns of the lattice.
+			@param maxWeight The heaviest an edge may be.
+
+			A lattice with every vertex joined to the ones beside, above and below it.
+			*/
+			void Grid(int rows, int columns, int maxWeight = 100);
+
+			/**
+			@param vertices The number of vertices.
+			@param edges The number of arcs.
+			@param maxWeight The heaviest an edge may be.
+
+			Arcs between vertices picked uniformly at random (the G(n, m) model).
+			*/
+			void ErdosRenyi(int vertices, int edges, int maxWeight = 100);
+
+			/**
+			@param scale The base 2 logarithm of the number of vertices.
+			@param edges The number of arcs.
+			@param maxWeight The heaviest an edge may be.
+			@param a The chance of recursing into the top left quadrant.
+			@param b The chance of recursing into the top right quadrant.
+			@param c The chance of recursing into the bottom left quadrant (the bottom right gets the rest).
+
+			Recursive matrix (R-MAT) arcs: each picks a quadrant of the adjacency matrix, then a quadrant
+			of that, and so on, giving the skewed, power law degrees of social and web graphs.
+			*/
+			void RMat(int scale, int edges, int maxWeight = 100, double a = 0.57, double b = 0.19, double c = 0.19);
+
+			/**
+			@param rows The rows of the lattice.
+			@param columns The columns of the lattice.
+
+			A road network stand-in: a lattice with every vertex nudged off its point, one in ten
+			streets missing, the odd diagonal, and weights the length of each street. Every
+			sixteenth row and column is a highway, which costs less than half as much to travel.
+			*/
+			void Road(int rows, int columns);
+
+		private:
+			typedef typename Graph<T>::EdgeTriple	EdgeTriple;	//!< Source identifier, destination identifier and weight of an edge.
+
+			Graph<T>					&graph;		//!< The Graph being filled.
+			boost::random::mt19937		random;		//!< The random numbers.
+			std::vector<EdgeTriple>		batch;		//!< The edges waiting for InsertEdges().
+
+			/**
+			@param count The number of vertices to insert.
+			@return The identifier of the first one.
+			*/
+			int InsertVertices(int count);
+
+			/**
+			@param low The smallest allowed.
+			@param high The largest allowed.
+			@return A number picked uniformly from low to high.
+			*/
+			int Uniform(int low, int high);
+
+			/**
+			@return A number picked uniformly from [0, 1).
+			*/
+			double Uniform(void);
+
+			/**
+			@param from Where the edge starts.
+			@param to Where the edge ends.
+			@param weight The weight of the edge.
+
+			Queue an edge both ways (once if the Graph is Undirected, which mirrors it anyway).
+			*/
+			void Street(int from, int to, int weight);
+
+			/**
+			Insert the queued edges.
+			*/
+			void Flush(void);
+	};
+
+	template<class T>
+	Generator<T>::Generator(Graph<T> &graph, unsigned int seed)
+	:graph(graph), random(seed), batch(std::vector<EdgeTriple>())
+	{
+	}
+
+	template<class T>
+	void Generator<T>::Grid(int rows, int columns, int maxWeight)
+	{
+		const int	first = InsertVertices(rows * columns);	// The top left corner.
+
+		batch.reserve(4 * rows * columns);
+		for (int i = 0; i < rows; i++)
+			for (int j = 0; j < columns; j++)
+			{
+				if (j + 1 < columns)
+					Street(first + i * columns + j, first + i * columns + j + 1, Uniform(1, maxWeight));
+				if (i + 1 < rows)
+					Street(first + i * columns + j, first + (i + 1) * columns + j, Uniform(1, maxWeight));
+			}
+		Flush();
+		return;
+	}
+
+	template<class T>
+	void Generator<T>::ErdosRenyi(int vertices, int edges, int maxWeight)
+	{
+		const int	first = InsertVertices(vertices);	// The first new vertex.
+
+		batch.reserve(edges);
+		for (int i = 0; i < edges; i++)
+			batch.push_back(EdgeTriple(first + Uniform(0, vertices - 1), first + Uniform(0, vertices - 1), Uniform(1, maxWeight)));
+		Flush();
+		return;
+	}
+
+	template<class T>
+	void Generator<T>::RMat(int scale, int edges, int maxWeight, double a, double b, double c)
+	{
+		const int	first = InsertVertices(1 << scale);	// The first new vertex.
+
+		batch.reserve(edges);
+		for (int i = 0; i < edges; i++)
+		{
+			int	from = 0,	// The row picked so far.
+				to = 0;		// The column picked so far.
+
+			for (int bit = scale - 1; bit >= 0; bit--)
+			{
+				const double	quadrant = Uniform();	// Which quarter of what's left.
+
+				if (quadrant >= a + b + c)
+				{
+					from |= 1 << bit;
+					to |= 1 << bit;
+				}
+				else if (quadrant >= a + b)
+					from |= 1 << bit;
+				else if (quadrant >= a)
+					to |= 1 << bit;
+			}
+			batch.push_back(EdgeTriple(first + from, first + to, Uniform(1, maxWeight)));
+		}
+		Flush();
+		return;
+	}
+
+	template<class T>
+	void Generator<T>::Road(int rows, int columns)
+	{
+		const int			first = InsertVertices(rows * columns);	// The top left corner.
+		std::vector<double>	x(rows * columns),						// Where each vertex was nudged to.
+							y(rows * columns);
+
+		for (int i = 0; i < rows * columns; i++)
+		{
+			x[i] = i % columns + 0.6 * Uniform() - 0.3;
+			y[i] = i / columns + 0.6 * Uniform() - 0.3;
+		}
+
+		batch.reserve(4 * rows * columns);
+		for (int i = 0; i < rows; i++)
+			for (int j = 0; j < columns; j++)
+			{
+				const int	here = i * columns + j;
+				int			neighbors[3] = {-1, -1, -1};	// Right, down and diagonally down.
+
+				if (j + 1 < columns && Uniform() < 0.9)
+					neighbors[0] = here + 1;
+				if (i + 1 < rows && Uniform() < 0.9)
+					neighbors[1] = here + columns;
+				if (j + 1 < columns && i + 1 < rows && Uniform() < 0.05)
+					neighbors[2] = here + columns + 1;
+
+				for (int k = 0; k < 3; k++)
+					if (neighbors[k] != -1)
+					{
+						const bool	highway = (k == 0 && i % 16 == 0) || (k == 1 && j % 16 == 0);
+						const double	length = std::sqrt((x[here] - x[neighbors[k]]) * (x[here] - x[neighbors[k]]) + (y[here] - y[neighbors[k]]) * (y[here] - y[neighbors[k]]));
+
+						Street(first + here, first + neighbors[k], static_cast<int>(length * (highway ? 40 : 100)) + 1);
+					}
+			}
+		Flush();
+		return;
+	}
+
+	template<class T>
+	int Generator<T>::InsertVertices(int count)
+	{
+		const int	first = graph.IndexCount();	// The identifier the first one gets.
+
+		graph.Reserve(count, 0);
+		for (int i = 0; i < count; i++)
+			graph.InsertNewVertex(T(i));
+		return first;
+	}
+
+	template<class T>
+	int Generator<T>::Uniform(int low, int high)
+	{
+		return boost::random::uniform_int_distribution<int>(low, high)(random);
+	}
+
+	template<class T>
+	double Generator<T>::Uniform(void)
+	{
+		return boost::random::uniform_real_distribution<double>(0.0, 1.0)(random);
+	}
+
+	template<class T>
+	void Generator<T>::Street(int from, int to, int weight)
+	{
+		batch.push_back(EdgeTriple(from, to, weight));
+		if (graph.IsDirected())
+			batch.push_back(EdgeTriple(to, from, weight));
+		return;
+	}
+
+	template<class T>
+	void Generator<T>::Flush(void)
+	{
+		graph.InsertEdges(batch.begin(), batch.end());
+		std::vector<EdgeTriple>().swap(batch);
+		return;
+	}
+}
+
+#endif
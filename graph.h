@@ -23,9 +23,23 @@
 #include <queue>
 #include <map>
 #include <cmath>
+#include <limits>
 #include <vector>
+#include <new>
+#include <iterator>
+#include <boost/type_traits/has_trivial_destructor.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/assert.hpp>
 
 #include "vertex.h"
+#include "arena.h"
+#include "searchstate.h"
+#include "stats.h"
+#include "graphlistener.h"
+#include "threadpool.h"
+#include "pathtree.h"
 
 /**
 @brief The Graphs namespace for all of our graphing tools.
@@ -35,39 +49,14 @@ be placed. It will keep our programming cleaner, and tighter.
 */
 namespace Graphs
 {
-	/**
-	@brief Weighting enum for keywording the Graph.
-
-	This enum allows us to pass the keyword to the graph upon instantiation.
-	This sets up the graph in the desired way so that we have more control in
-	whether it is weighted.
-	*/
-	enum Weighting
-	{
-		Weighted,						//!< Weighted Graph will be created.
-		Unweighted						//!< Unweighted Graph will be created.
-	};
-
-	/**
-	@brief Direction enum for keywording the Graph.
-
-	This enum allows us to pass the keyword to the graph upon instantiation.
-	This sets up the graph in the desired way so that we have more control in
-	whether it is weighted.
-	*/
-	enum Direction
-	{
-		Directed,						//!< Directed Graph will be created.
-		Undirected						//!< Undirected Graph will be created.
-	};
-
 	/**
 	Fun Things...
 	*/
-	template<class T> class Graph;
+	template<class T, Direction D, Weighting W, class WeightType>
+	std::ostream &operator <<(std::ostream &, const Graph<T, D, W, WeightType> &);
+
 	template<class T>
-	std::ostream &operator <<(std::ostream &, const Graph<T> &);
-	const int Infinity = static_cast<int>(pow(2,32));
+	class GraphBuilder;
 
 	/**
 	@class Graph graph.h
@@ -75,20 +64,35 @@ namespace Graphs
 	@author Alex Brandt <alunduil@alunduil.com>
 
 	This Graph can be Weighted, Unweighted, Directed, or Undirected.
+
+	The choice can be made at compile time, e.g. Graph<City, Directed, Weighted>,
+	which takes the tests on it out of the edge loops, and makes an Unweighted
+	Graph's edges a pointer each (see EdgeStorage). WeightType is what each
+	edge's weight is stored as. Left as RuntimeDirection and RuntimeWeighting
+	(the defaults) the choice is the constructor's, as it always was.
 	*/
-	template<class T>
+	template<class T, Direction D, Weighting W, class WeightType>
 	class Graph
 	{
 		public:
+			typedef boost::tuple<int, int, int>						EdgeTriple;	//!< Source identifier, destination identifier and weight of an edge.
+			typedef std::pair<const Vertex<T, W, WeightType>*, const Vertex<T, W, WeightType>*>	Query;		//!< Source and destination of a ShortestPaths() query.
+
 			/**
+			@param weighting Weighted or Unweighted; must be W itself unless W is RuntimeWeighting.
+			@param direction Directed or Undirected; must be D itself unless D is RuntimeDirection.
+
 			Constructor
 			*/
-			Graph(Weighting weighting = Unweighted, Direction direction = Undirected);
+			Graph(Weighting weighting, Direction direction = D == RuntimeDirection ? Undirected : D);
 
 			/**
+			@param direction Directed or Undirected; must be D itself unless D is RuntimeDirection.
+			@param weighting Weighted or Unweighted; must be W itself unless W is RuntimeWeighting.
+
 			Constructor
 			*/
-			Graph(Direction direction = Undirected, Weighting weighting = Unweighted);
+			Graph(Direction direction, Weighting weighting = W == RuntimeWeighting ? Unweighted : W);
 
 			/**
 			Constructor
@@ -103,12 +107,12 @@ namespace Graphs
 			/**
 			Copy Constructor
 			*/
-			Graph(const Graph<T> &otherGraph);
+			Graph(const Graph<T, D, W, WeightType> &otherGraph);
 
 			/**
 			Assignment Operator
 			*/
-			Graph &operator=(const Graph<T> &otherGraph);
+			Graph &operator=(const Graph<T, D, W, WeightType> &otherGraph);
 
 			/**
 			Delete all edges and vertices.
@@ -138,13 +142,86 @@ namespace Graphs
 			*/
 			int VertexCount(void) const;
 
+			/**
+			@return True if the Graph was built Weighted.
+
+			Unweighted graphs count every edge as one hop, whatever weight it was given.
+			*/
+			bool IsWeighted(void) const;
+
+			/**
+			@return True if the Graph was built Directed.
+			*/
+			bool IsDirected(void) const;
+
+			/**
+			@return One past the largest vertex identifier handed out.
+			@sa VertexAt()
+
+			Size needed by any flat array indexed by Vertex::Index().
+			*/
+			int IndexCount(void) const;
+
+			/**
+			@param index The dense identifier of the vertex.
+			@return The vertex, or NULL if it has been deleted.
+			@sa IndexCount()
+			*/
+			Vertex<T, W, WeightType> * VertexAt(int index) const;
+
+			/**
+			@param vertex A vertex of the Graph.
+			@return Iterator to the first edge into the vertex.
+			@sa InEdgesEnd()
+
+			Walk the edges into a vertex in place; boost::get<0>() of an edge is its start. A Directed
+			Graph keeps these alongside the edges out; an Undirected Graph's edges in are its edges out.
+			*/
+			typename Vertex<T, W, WeightType>::EdgeIterator InEdgesBegin(const Vertex<T, W, WeightType> &vertex) const;
+
+			/**
+			@param vertex A vertex of the Graph.
+			@return Iterator one past the last edge into the vertex.
+			@sa InEdgesBegin()
+			*/
+			typename Vertex<T, W, WeightType>::EdgeIterator InEdgesEnd(const Vertex<T, W, WeightType> &vertex) const;
+
+			/**
+			@param vertex A vertex of the Graph.
+			@return The number of edges into the vertex.
+			*/
+			int InDegree(const Vertex<T, W, WeightType> &vertex) const;
+
+			/**
+			@param enable Whether vertices should keep a weight index.
+			@sa Vertex::IndexWeights()
+
+			Turn the per-vertex neighbor to weight hashes on or off, for the vertices already here and those inserted later.
+			*/
+			void IndexWeights(bool enable = true);
+
+			/**
+			@param listener The listener to tell about changes from now on.
+			@sa Detach()
+
+			The listener must be detached before it goes away.
+			*/
+			void Attach(GraphListener<T, W, WeightType> &listener);
+
+			/**
+			@param listener The listener to stop telling about changes.
+			@sa Attach()
+			*/
+			void Detach(GraphListener<T, W, WeightType> &listener);
+
 			/**
 			@param otherVertex Vertex to insert into the Graph.
 			@sa InsertEdge()
 
-			Insert a vertex into the graph. NOTE: This allocates a new vertex to ensure the reference doesn't go out of scope.
+			Insert a vertex into the graph. NOTE: This allocates a new vertex (from the Graph's Arena) to ensure the reference doesn't go out of scope.
+			The new vertex is given the next dense identifier.
 			*/
-			Vertex<T> & InsertVertex(const Vertex<T> &otherVertex);
+			Vertex<T, W, WeightType> & InsertVertex(const Vertex<T, W, WeightType> &otherVertex);
 
 			/**
 			@param data The data to insert in the new vertex.
@@ -152,7 +229,7 @@ namespace Graphs
 
 			Pass the data to the Insert method allowing the vertex to be created as it's inserted.
 			*/
-			Vertex<T> & InsertNewVertex(const T &data);
+			Vertex<T, W, WeightType> & InsertNewVertex(const T &data);
 
 			/**
 			@param vertexA Starting vertex for the edge.
@@ -162,7 +239,7 @@ namespace Graphs
 
 			Insert an edge into the Graph.
 			*/
-			void InsertEdge(Vertex<T> &vertexA, Vertex<T> &vertexB, const int weight = 1);
+			void InsertEdge(Vertex<T, W, WeightType> &vertexA, Vertex<T, W, WeightType> &vertexB, const int weight = 1);
 
 			/**
 			@param vertexA Starting vertex for the edge.
@@ -173,7 +250,29 @@ namespace Graphs
 
 			Insert a bidirectional edge into the graph.
 			*/
-			void InsertBidirectionalEdge(Vertex<T> &vertexA, Vertex<T> &vertexB, const int weight = 1);
+			void InsertBidirectionalEdge(Vertex<T, W, WeightType> &vertexA, Vertex<T, W, WeightType> &vertexB, const int weight = 1);
+
+			/**
+			@param first The first EdgeTriple to insert.
+			@param last One past the last EdgeTriple to insert.
+			@return The number of edges inserted.
+			@sa InsertEdge()
+			@sa Reserve()
+
+			Insert a batch of edges between vertices already in the Graph, given by their dense identifiers.
+			The batch is grouped by source first so that every vertex's edges are laid down together.
+			Triples naming an identifier out of range or deleted are skipped.
+			*/
+			template<class InputIterator>
+			int InsertEdges(InputIterator first, InputIterator last);
+
+			/**
+			@param vertices The number of vertices about to be inserted.
+			@param edges The number of adjacency entries about to be inserted.
+
+			Size the Graph's storage up front so a large load doesn't grow it piecemeal.
+			*/
+			void Reserve(int vertices, int edges);
 
 			/**
 			@param vertexA Starting vertex for the edge.
@@ -182,15 +281,25 @@ namespace Graphs
 
 			Delete a specific edge from the graph.
 			*/
-			void DeleteEdge(Vertex<T> &vertexA, Vertex<T> &vertexB);
+			void DeleteEdge(Vertex<T, W, WeightType> &vertexA, Vertex<T, W, WeightType> &vertexB);
+
+			/**
+			@param vertexA Starting vertex for the edge.
+			@param vertexB Finishing vertex for the edge.
+			@param weight The new weight.
+			@sa InsertEdge()
+
+			Change the weight of an edge already in the Graph (of every edge, if there are parallel ones).
+			*/
+			void SetWeight(Vertex<T, W, WeightType> &vertexA, Vertex<T, W, WeightType> &vertexB, const int weight);
 
 			/**
 			@param otherVertex Vertex to remove from the graph.
 			@sa DeleteEdge
 
-			Delete a specified vertex, and it's associated edges.
+			Delete a specified vertex, and it's associated edges. Only the vertices at the other ends of its edges are visited.
 			*/
-			void DeleteVertex(const Vertex<T> &otherVertex);
+			void DeleteVertex(const Vertex<T, W, WeightType> &otherVertex);
 
 			/**
 			Simply dumps out the graph's contents.
@@ -203,7 +312,7 @@ namespace Graphs
 
 			Finds all the instances matched by the predicate used, and places references in a set to be returned.
 			*/
-			std::list<Vertex<T> &> FindAll(boost::function<bool (const Vertex<T> &)> predicate);
+			std::list<Vertex<T, W, WeightType> &> FindAll(boost::function<bool (const Vertex<T, W, WeightType> &)> predicate);
 
 			/**
 			@param predicate Predicate function to determine when we've found an item in question.
@@ -211,7 +320,7 @@ namespace Graphs
 
 			Finds the first instance matched by the predicate used, and returns a reference.
 			*/
-			Vertex<T> & FindVertex(boost::function<bool (const Vertex<T> &)> predicate);
+			Vertex<T, W, WeightType> & FindVertex(boost::function<bool (const Vertex<T, W, WeightType> &)> predicate);
 
 			/**
 			@param predicate Predicate function to determine when we've found an item in question.
@@ -219,7 +328,7 @@ namespace Graphs
 
 			Finds the first instance matched by the predicate used, and returns a reference.
 			*/
-			Vertex<T> & FindVertex(boost::function<bool (const Vertex<T> *)> predicate);
+			Vertex<T, W, WeightType> & FindVertex(boost::function<bool (const Vertex<T, W, WeightType> *)> predicate);
 
 			/**
 			@param predicate Predicate function to determine when we'be found an item in question.
@@ -227,79 +336,346 @@ namespace Graphs
 
 			Finds the first instance matched by the predicate used, and returns a reference.
 			*/
-			Vertex<T> & Find(boost::function<bool (const T &)> predicate);
+			Vertex<T, W, WeightType> & Find(boost::function<bool (const T &)> predicate);
+
+			/**
+			@param vertexA The source vertex.
+			@param vertexB The destination vertex.
+			@return A queue that is the path to follow.
+
+			Dijkstra's shortest path from one node to another, or a breadth first search if the Graph is Unweighted.
+			@sa BreadthFirst
+			*/
+			std::queue<Vertex<T, W, WeightType>*> ShortestPath(const Vertex<T, W, WeightType> &vertexA, const Vertex<T, W, WeightType> &vertexB);
+
+			/**
+			@param vertexA The source vertex.
+			@param vertexB The destination vertex.
+			@param searchState The scratch space to search in.
+			@return A queue that is the path to follow.
+
+			Dijkstra's shortest path from one node to another. This only reads the Graph, so any number
+			of threads may run it at once as long as each brings its own SearchState and nobody changes the Graph.
+			*/
+			std::queue<Vertex<T, W, WeightType>*> ShortestPath(const Vertex<T, W, WeightType> &vertexA, const Vertex<T, W, WeightType> &vertexB, SearchState &searchState) const;
+
+			/**
+			@param vertexA The source vertex.
+			@param vertexB The destination vertex.
+			@return A queue that is the path to follow.
+
+			Dijkstra's shortest path grown from both ends at once, forward from vertexA along the edges out
+			and backward from vertexB along the edges in (InEdgesBegin()), until the two searches meet.
+			Each search covers roughly the ball of half the path's length, so far fewer vertices are
+			settled than by ShortestPath() on large, spread out graphs.
+			*/
+			std::queue<Vertex<T, W, WeightType>*> BidirectionalShortestPath(const Vertex<T, W, WeightType> &vertexA, const Vertex<T, W, WeightType> &vertexB);
+
+			/**
+			@param vertexA The source vertex.
+			@param vertexB The destination vertex.
+			@param forward The scratch space for the search from the source.
+			@param backward The scratch space for the search from the destination.
+			@return A queue that is the path to follow.
+
+			As above, for any number of threads at once, each with its own pair of SearchStates.
+			*/
+			std::queue<Vertex<T, W, WeightType>*> BidirectionalShortestPath(const Vertex<T, W, WeightType> &vertexA, const Vertex<T, W, WeightType> &vertexB, SearchState &forward, SearchState &backward) const;
 
 			/**
 			@param vertexA The source vertex.
 			@param vertexB The destination vertex.
+			@param heuristic Called as heuristic(vertex, vertexB) for a lower bound on the distance from vertex to vertexB.
 			@return A queue that is the path to follow.
 
-			Dijkstra's shortest path from one node to another.
+			A* shortest path from one node to another: Dijkstra's algorithm with the frontier ordered
+			by distance plus the heuristic's estimate of the distance left, so the search heads
+			for vertexB rather than spreading out evenly. The heuristic must never overestimate and
+			must be consistent (the estimate may not fall by more than the weight of an edge
+			from one end of it to the other), otherwise the path found may not be the shortest.
+			A great circle distance between coordinates kept in T is the usual choice.
+			@sa ShortestPath
 			*/
-			std::queue<Vertex<T>*> ShortestPath(const Vertex<T> &vertexA, const Vertex<T> &vertexB);
+			template<class Heuristic>
+			std::queue<Vertex<T, W, WeightType>*> AStarShortestPath(const Vertex<T, W, WeightType> &vertexA, const Vertex<T, W, WeightType> &vertexB, Heuristic heuristic);
+
+			/**
+			@param vertexA The source vertex.
+			@param vertexB The destination vertex.
+			@param heuristic Called as heuristic(vertex, vertexB) for a lower bound on the distance from vertex to vertexB.
+			@param searchState The scratch space to search in.
+			@return A queue that is the path to follow.
+
+			A* shortest path from one node to another, searching in the given SearchState so that
+			several threads may run it at once.
+			*/
+			template<class Heuristic>
+			std::queue<Vertex<T, W, WeightType>*> AStarShortestPath(const Vertex<T, W, WeightType> &vertexA, const Vertex<T, W, WeightType> &vertexB, Heuristic heuristic, SearchState &searchState) const;
+
+			/**
+			@param source The source vertex.
+			@return The shortest paths from the source to every vertex.
+			@sa ShortestPathCache
+
+			Dijkstra's shortest path from one node to all the others, so that any number of
+			destinations can be read off one search. Unweighted graphs get a breadth first search.
+			*/
+			PathTree<T, W, WeightType> ShortestPathTree(const Vertex<T, W, WeightType> &source);
+
+			/**
+			@param source The source vertex.
+			@param searchState The scratch space to search in.
+			@return The shortest paths from the source to every vertex.
+			*/
+			PathTree<T, W, WeightType> ShortestPathTree(const Vertex<T, W, WeightType> &source, SearchState &searchState) const;
+
+			/**
+			@param queries The source and destination of each path wanted.
+			@param pool The threads to answer them with.
+			@return The paths, in the same order as the queries.
+
+			Answer a batch of shortest path queries in parallel. Each worker keeps its own SearchState from batch to batch.
+			*/
+			std::vector<std::queue<Vertex<T, W, WeightType>*> > ShortestPaths(const std::vector<Query> &queries, ThreadPool &pool);
+
+			/**
+			@param queries The source and destination of each path wanted.
+			@return The paths, in the same order as the queries.
+
+			Answer a batch of shortest path queries in parallel, on a pool of one thread per core that the Graph keeps.
+			*/
+			std::vector<std::queue<Vertex<T, W, WeightType>*> > ShortestPaths(const std::vector<Query> &queries);
+
+			/**
+			@return The bytes the Graph holds for vertices and edges.
+			*/
+			std::size_t Footprint(void) const;
+
+			/**
+			@return The work and time of every ShortestPath(), AStarShortestPath() and ShortestPathTree() so far (all zero unless Instrumented).
+			*/
+			const GraphStats &Stats(void) const;
+
+			/**
+			Start the Stats() counting again from zero.
+			*/
+			void ResetStats(void);
 		private:
-			std::set<Vertex<T>*>		vertices;		//!< The vertices of the graph.
+			friend class GraphBuilder<T>;	// Hands over edges it has already grouped by source.
+
+			typedef std::set<Vertex<T, W, WeightType>*, std::less<Vertex<T, W, WeightType>*>, ArenaAllocator<Vertex<T, W, WeightType>*> >	VertexSet;	//!< Set of vertices drawn from the Arena.
+
+			Arena						arena;			//!< Where the vertices and edges live (declared first so it goes last).
+			VertexSet					vertices;		//!< The vertices of the graph.
+			std::vector<Vertex<T, W, WeightType>*>		index;			//!< The vertices by dense identifier (NULL once deleted).
+			SearchState					searchState;	//!< Scratch space reused by every ShortestPath().
+			SearchState					backwardState;	//!< Scratch space for the backward half of BidirectionalShortestPath().
 			Weighting					weighting;		//!< Weighted graph?
 			Direction					direction;		//!< Directed graph?
 			int							edgeCount;		//!< Number of edges.
+			bool						indexWeights;	//!< Do vertices keep a weight index?
+			std::list<GraphListener<T, W, WeightType>*>	listeners;	//!< Who to tell about changes.
+			std::vector<SearchState>	workerStates;	//!< Scratch space for each ShortestPaths() worker.
+			boost::scoped_ptr<ThreadPool>	pool;		//!< Threads for ShortestPaths() (made on first use).
+			mutable GraphStats			stats;			//!< The work and time of every query (counted by the const queries too).
+
+			/**
+			@param queries The batch being answered.
+			@param paths Where the answers go.
+			@param next The next unclaimed query.
+			@param worker The worker's number.
+
+			A ShortestPaths() worker: claim queries a few at a time until they're all gone.
+			*/
+			void AnswerQueries(const std::vector<Query> &queries, std::vector<std::queue<Vertex<T, W, WeightType>*> > &paths, boost::atomic<int> &next, int worker);
+
+			/**
+			@param otherVertex The vertex to copy into the Arena.
+			@return The Graph's own copy, with the next dense identifier.
+			*/
+			Vertex<T, W, WeightType> * PlaceVertex(const Vertex<T, W, WeightType> &otherVertex);
+
+			/**
+			@param vertex A vertex placed by PlaceVertex() to give back to the Arena.
+			*/
+			void ReleaseVertex(Vertex<T, W, WeightType> *vertex);
+
+			/**
+			@param otherGraph The Graph to copy the vertices and edges of.
+
+			Deep copy into this (empty) Graph, keeping the dense identifiers.
+			*/
+			void CopyFrom(const Graph<T, D, W, WeightType> &otherGraph);
+
+			/**
+			@param vertexA Starting vertex for the edge.
+			@param vertexB Finishing vertex for the edge.
+			@param weight The weight of the edge.
+
+			Add one edge, and its entry among vertexB's edges in if the Graph is Directed.
+			*/
+			void Link(Vertex<T, W, WeightType> &vertexA, Vertex<T, W, WeightType> &vertexB, const int weight);
+
+			/**
+			@param grouped Edges naming live vertices, every source's together, mirrored already if the Graph is Undirected.
+
+			Link a batch, one source's edges after another; the second half of InsertEdges().
+			*/
+			void LinkGrouped(const std::vector<EdgeTriple> &grouped);
+
+			/**
+			@param first The first of the edges as given.
+			@param last Past the last of them.
+
+			Count edges linked by LinkGrouped() and tell the listeners about them.
+			*/
+			template<class ForwardIterator>
+			void EdgesLinked(ForwardIterator first, ForwardIterator last);
+
+			/**
+			@param vertexA Starting vertex for the edges.
+			@param vertexB Finishing vertex for the edges.
+
+			Drop the edges from one vertex to another, and their entries among vertexB's edges in.
+			*/
+			void Unlink(Vertex<T, W, WeightType> &vertexA, Vertex<T, W, WeightType> &vertexB);
 	};
 
-	template<class T>
-	Graph<T>::Graph(Weighting weighting, Direction direction)
-	:vertices(std::set<Vertex<T>*>()), weighting(weighting), direction(direction), edgeCount(0)
+	template<class T, Direction D, Weighting W, class WeightType>
+	Graph<T, D, W, WeightType>::Graph(Weighting weighting, Direction direction)
+	:arena(), vertices(VertexSet(std::less<Vertex<T, W, WeightType>*>(), ArenaAllocator<Vertex<T, W, WeightType>*>(&arena))), index(std::vector<Vertex<T, W, WeightType>*>()), searchState(SearchState()), backwardState(SearchState()), weighting(W == RuntimeWeighting ? weighting : W), direction(D == RuntimeDirection ? direction : D), edgeCount(0), indexWeights(false), listeners(std::list<GraphListener<T, W, WeightType>*>()), workerStates(std::vector<SearchState>()), pool(), stats()
 	{
+		/*
+		A choice the template arguments already made can't be made again.
+		*/
+		BOOST_ASSERT(weighting != RuntimeWeighting && (W == RuntimeWeighting || weighting == W));
+		BOOST_ASSERT(direction != RuntimeDirection && (D == RuntimeDirection || direction == D));
 	}
 
-	template<class T>
-	Graph<T>::Graph(Direction direction, Weighting weighting)
-	:vertices(std::set<Vertex<T>*>()), weighting(weighting), direction(direction), edgeCount(0)
+	template<class T, Direction D, Weighting W, class WeightType>
+	Graph<T, D, W, WeightType>::Graph(Direction direction, Weighting weighting)
+	:arena(), vertices(VertexSet(std::less<Vertex<T, W, WeightType>*>(), ArenaAllocator<Vertex<T, W, WeightType>*>(&arena))), index(std::vector<Vertex<T, W, WeightType>*>()), searchState(SearchState()), backwardState(SearchState()), weighting(W == RuntimeWeighting ? weighting : W), direction(D == RuntimeDirection ? direction : D), edgeCount(0), indexWeights(false), listeners(std::list<GraphListener<T, W, WeightType>*>()), workerStates(std::vector<SearchState>()), pool(), stats()
 	{
+		BOOST_ASSERT(weighting != RuntimeWeighting && (W == RuntimeWeighting || weighting == W));
+		BOOST_ASSERT(direction != RuntimeDirection && (D == RuntimeDirection || direction == D));
 	}
 
-	template<class T>
-	Graph<T>::Graph()
-	:vertices(std::set<Vertex<T>*>()), weighting(Unweighted), direction(Undirected), edgeCount(0)
+	template<class T, Direction D, Weighting W, class WeightType>
+	Graph<T, D, W, WeightType>::Graph()
+	:arena(), vertices(VertexSet(std::less<Vertex<T, W, WeightType>*>(), ArenaAllocator<Vertex<T, W, WeightType>*>(&arena))), index(std::vector<Vertex<T, W, WeightType>*>()), searchState(SearchState()), backwardState(SearchState()), weighting(W == RuntimeWeighting ? Unweighted : W), direction(D == RuntimeDirection ? Undirected : D), edgeCount(0), indexWeights(false), listeners(std::list<GraphListener<T, W, WeightType>*>()), workerStates(std::vector<SearchState>()), pool(), stats()
 	{
 	}
 
-	template<class T>
-	Graph<T>::~Graph()
+	template<class T, Direction D, Weighting W, class WeightType>
+	Graph<T, D, W, WeightType>::~Graph()
 	{
+		Destroy();
 	}
 
-	template<class T>
-	Graph<T>::Graph(const Graph<T> &otherGraph)
-	:vertices(otherGraph.vertices), weighting(otherGraph.weighting), direction(otherGraph.direction), edgeCount(otherGraph.edgeCount)
+	template<class T, Direction D, Weighting W, class WeightType>
+	Graph<T, D, W, WeightType>::Graph(const Graph<T, D, W, WeightType> &otherGraph)
+	:arena(), vertices(VertexSet(std::less<Vertex<T, W, WeightType>*>(), ArenaAllocator<Vertex<T, W, WeightType>*>(&arena))), index(std::vector<Vertex<T, W, WeightType>*>()), searchState(SearchState()), backwardState(SearchState()), weighting(otherGraph.weighting), direction(otherGraph.direction), edgeCount(0), indexWeights(otherGraph.indexWeights), listeners(std::list<GraphListener<T, W, WeightType>*>()), workerStates(std::vector<SearchState>()), pool(), stats()
 	{
-		transform(otherGraph.vertices.begin(), otherGraph.vertices.end(), vertices.begin(), boost::lambda::bind(&(new Vertex<T>), otherGraph.vertices, boost::lambda::_1));
+		CopyFrom(otherGraph);
 	}
 
-	template<class T>
-	void Graph<T>::DeleteEdge(Vertex<T> &vertexA, Vertex<T> &vertexB)
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::DeleteEdge(Vertex<T, W, WeightType> &vertexA, Vertex<T, W, WeightType> &vertexB)
 	{
-		vertexA.DeleteNeighbor(vertexB);
-		if (direction == Undirected)
-			vertexB.DeleteNeighbor(vertexA);
-		edgeCount--;
+		const int	degree = vertexA.Degree();	// Degree before the edges to vertexB are dropped.
+
+		Unlink(vertexA, vertexB);
+		if (!IsDirected())
+			Unlink(vertexB, vertexA);
+		edgeCount -= !IsDirected() && &vertexA == &vertexB ? (degree - vertexA.Degree()) / 2 : degree - vertexA.Degree();
+		for (typename std::list<GraphListener<T, W, WeightType>*>::iterator i = listeners.begin(); i != listeners.end(); i++)
+			(*i)->EdgeDeleted(vertexA, vertexB);
 		return;
 	}
 
-	template<class T>
-	void Graph<T>::DeleteVertex(const Vertex<T> &otherVertex)
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::SetWeight(Vertex<T, W, WeightType> &vertexA, Vertex<T, W, WeightType> &vertexB, const int weight)
 	{
-		vertices.erase(const_cast<Vertex<T>*>(&otherVertex));
+		const int	oldWeight = vertexA.GetWeight(vertexB);	// What the listeners are told it was.
+
+		if (!vertexA.SetWeight(vertexB, weight))
+			return;
+		if (!IsDirected())
+			vertexB.SetWeight(vertexA, weight);
+		else
+			vertexB.SetInWeight(vertexA, weight);
+		for (typename std::list<GraphListener<T, W, WeightType>*>::iterator i = listeners.begin(); i != listeners.end(); i++)
+			(*i)->WeightChanged(vertexA, vertexB, oldWeight, weight);
 		return;
 	}
 
-	template<class T>
-	void Graph<T>::Destroy(void)
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::DeleteVertex(const Vertex<T, W, WeightType> &otherVertex)
+	{
+		Vertex<T, W, WeightType>	*vertex = const_cast<Vertex<T, W, WeightType>*>(&otherVertex);	// The vertex going away.
+		int			removed = vertex->Degree();						// Adjacency entries going with it.
+		typename Vertex<T, W, WeightType>::EdgeIterator	i;
+
+		if (vertex->index < 0 || vertex->index >= IndexCount() || index[vertex->index] != vertex)
+			return;
+
+		for (typename std::list<GraphListener<T, W, WeightType>*>::iterator i = listeners.begin(); i != listeners.end(); i++)
+			(*i)->VertexDeleted(otherVertex);
+
+		/*
+		The ends of our edges forget them as edges in, and the starts of our
+		edges in forget them as edges out. Parallel edges make a neighbor turn
+		up more than once; the later visits find nothing left to drop.
+		*/
+		if (IsDirected())
+			for (i = vertex->EdgesBegin(); i != vertex->EdgesEnd(); i++)
+				if (boost::get<0>(*i) != vertex)
+					boost::get<0>(*i)->DeleteInNeighbor(*vertex);
+		for (i = InEdgesBegin(*vertex); i != InEdgesEnd(*vertex); i++)
+			if (boost::get<0>(*i) != vertex)
+			{
+				Vertex<T, W, WeightType>	*neighbor = boost::get<0>(*i);	// The start of an edge in.
+				int							degree = neighbor->Degree();	// Degree before the edges to vertex are dropped.
+
+				neighbor->DeleteNeighbor(*vertex);
+				removed += degree - neighbor->Degree();
+			}
+		edgeCount -= !IsDirected() ? removed / 2 : removed;
+
+		vertices.erase(vertex);
+		index[vertex->index] = NULL;
+		ReleaseVertex(vertex);
+		return;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::Destroy(void)
 	{
+		for (typename std::list<GraphListener<T, W, WeightType>*>::iterator i = listeners.begin(); i != listeners.end(); i++)
+			for (typename VertexSet::iterator j = vertices.begin(); j != vertices.end(); j++)
+				(*i)->VertexDeleted(**j);
+
+		/*
+		The edge lists live entirely in the Arena, so only a vertex's data and
+		weight index, which may own memory elsewhere, are destroyed. Running
+		the whole destructor would hand every edge node back to the Arena one
+		at a time just before the chunks are released.
+		*/
+		for (typename VertexSet::iterator i = vertices.begin(); i != vertices.end(); i++)
+		{
+			if (!boost::has_trivial_destructor<T>::value)
+				(*i)->mrRogers.~T();
+			delete (*i)->weightIndex;
+		}
 		vertices.clear();
+		index.clear();
+		arena.Release();
+		edgeCount = 0;
 		return;
 	}
 
-	template<class T>
-	std::ostream &Graph<T>::Dump(std::ostream &out) const
+	template<class T, Direction D, Weighting W, class WeightType>
+	std::ostream &Graph<T, D, W, WeightType>::Dump(std::ostream &out) const
 	{
 		out << "Dumping graph:" << std::endl;
 		out << "\tNumber of Vertices: " << VertexCount() << "\tNumber of Edges: " << EdgeCount() << "\n";
@@ -309,184 +685,577 @@ namespace Graphs
 		return out;
 	}
 
-	template<class T>
-	int Graph<T>::EdgeCount(void) const
+	template<class T, Direction D, Weighting W, class WeightType>
+	int Graph<T, D, W, WeightType>::EdgeCount(void) const
 	{
 		return edgeCount;
 	}
 
-	template<class T>
-	void Graph<T>::InsertEdge(Vertex<T> &vertexA, Vertex<T> &vertexB, const int weight)
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::InsertEdge(Vertex<T, W, WeightType> &vertexA, Vertex<T, W, WeightType> &vertexB, const int weight)
 	{
-		vertexA.CreateNeighbor(vertexB, weight);
-		if (direction == Undirected)
-			vertexB.CreateNeighbor(vertexA, weight);
+		Link(vertexA, vertexB, weight);
+		if (!IsDirected())
+			Link(vertexB, vertexA, weight);
 		edgeCount++;
+		for (typename std::list<GraphListener<T, W, WeightType>*>::iterator i = listeners.begin(); i != listeners.end(); i++)
+			(*i)->EdgeInserted(vertexA, vertexB, weight);
 		return;
 	}
 
-	template<class T>
-	void Graph<T>::InsertBidirectionalEdge(Vertex<T> &vertexA, Vertex<T> &vertexB, const int weight)
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::InsertBidirectionalEdge(Vertex<T, W, WeightType> &vertexA, Vertex<T, W, WeightType> &vertexB, const int weight)
 	{
-		vertexA.CreateNeighbor(vertexB, weight);
-		vertexB.CreateNeighbor(vertexA, weight);
+		Link(vertexA, vertexB, weight);
+		Link(vertexB, vertexA, weight);
 		edgeCount++;
 		edgeCount++;
+		for (typename std::list<GraphListener<T, W, WeightType>*>::iterator i = listeners.begin(); i != listeners.end(); i++)
+		{
+			(*i)->EdgeInserted(vertexA, vertexB, weight);
+			(*i)->EdgeInserted(vertexB, vertexA, weight);
+		}
 		return;
 	}
 
-	template<class T>
-	Vertex<T> & Graph<T>::InsertVertex(const Vertex<T> &otherVertex)
+	template<class T, Direction D, Weighting W, class WeightType>
+	template<class InputIterator>
+	int Graph<T, D, W, WeightType>::InsertEdges(InputIterator first, InputIterator last)
+	{
+		using namespace std;
+
+		vector<EdgeTriple>	batch;					// The edges as given, less any naming a missing vertex.
+		vector<int>			offsets(IndexCount() + 1, 0);	// Where each source's edges start in grouped.
+
+		/*
+		Everything below indexes by identifier, so drop bad ones before anything is touched.
+		*/
+		for (; first != last; first++)
+		{
+			const int	source = boost::get<0>(*first),
+						destination = boost::get<1>(*first);
+
+			if (source >= 0 && source < IndexCount() && index[source] != NULL && destination >= 0 && destination < IndexCount() && index[destination] != NULL)
+				batch.push_back(*first);
+		}
+
+		const int			inserted = batch.size();	// Edges as the Graph counts them.
+
+		if (!IsDirected())
+		{
+			batch.reserve(2 * inserted);
+			for (int i = 0; i < inserted; i++)
+				batch.push_back(EdgeTriple(boost::get<1>(batch[i]), boost::get<0>(batch[i]), boost::get<2>(batch[i])));
+		}
+
+		/*
+		Counting sort by source; it's linear and keeps each source's edges in the order given.
+		*/
+		for (typename vector<EdgeTriple>::iterator i = batch.begin(); i != batch.end(); i++)
+			offsets[boost::get<0>(*i) + 1]++;
+		for (int i = 0; i < IndexCount(); i++)
+			offsets[i + 1] += offsets[i];
+
+		vector<EdgeTriple>	grouped(batch.size());	// The edges grouped by source.
+
+		for (typename vector<EdgeTriple>::iterator i = batch.begin(); i != batch.end(); i++)
+			grouped[offsets[boost::get<0>(*i)]++] = *i;
+
+		LinkGrouped(grouped);
+		EdgesLinked(batch.begin(), batch.begin() + inserted);
+		return inserted;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::LinkGrouped(const std::vector<EdgeTriple> &grouped)
 	{
-		return **vertices.insert(new Vertex<T>(otherVertex)).first;
+		Reserve(0, grouped.size());
+		for (typename std::vector<EdgeTriple>::const_iterator i = grouped.begin(); i != grouped.end(); i++)
+			Link(*index[boost::get<0>(*i)], *index[boost::get<1>(*i)], boost::get<2>(*i));
+		return;
 	}
 
-	template<class T>
-	Vertex<T> & Graph<T>::InsertNewVertex(const T &data)
+	template<class T, Direction D, Weighting W, class WeightType>
+	template<class ForwardIterator>
+	void Graph<T, D, W, WeightType>::EdgesLinked(ForwardIterator first, ForwardIterator last)
 	{
-		return InsertVertex(Vertex<T>(data));
+		/*
+		Listeners hear about the edges as given, not the mirrored copies.
+		*/
+		edgeCount += std::distance(first, last);
+		for (typename std::list<GraphListener<T, W, WeightType>*>::iterator i = listeners.begin(); i != listeners.end(); i++)
+			for (ForwardIterator j = first; j != last; j++)
+				(*i)->EdgeInserted(*index[boost::get<0>(*j)], *index[boost::get<1>(*j)], boost::get<2>(*j));
+		return;
 	}
 
-	template<class T>
-	bool Graph<T>::IsEmpty(void) const
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::Reserve(int vertices, int edges)
+	{
+		/*
+		Estimates of what the containers allocate per element: a list node is
+		two links and the edge, a set node three links, a colour and the pointer.
+		*/
+		const std::size_t	edgeBytes = 2 * sizeof(void*) + sizeof(typename Vertex<T, W, WeightType>::Edge),
+							vertexBytes = sizeof(Vertex<T, W, WeightType>) + 5 * sizeof(void*);
+
+		index.reserve(index.size() + vertices);
+		arena.Reserve(vertices * vertexBytes + edges * edgeBytes * (IsDirected() ? 2 : 1));
+		return;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	Vertex<T, W, WeightType> & Graph<T, D, W, WeightType>::InsertVertex(const Vertex<T, W, WeightType> &otherVertex)
+	{
+		Vertex<T, W, WeightType>	*newVertex = PlaceVertex(otherVertex);	// Our own copy of the vertex.
+
+		for (typename std::list<GraphListener<T, W, WeightType>*>::iterator i = listeners.begin(); i != listeners.end(); i++)
+			(*i)->VertexInserted(*newVertex);
+		return *newVertex;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	Vertex<T, W, WeightType> & Graph<T, D, W, WeightType>::InsertNewVertex(const T &data)
+	{
+		return InsertVertex(Vertex<T, W, WeightType>(data));
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	bool Graph<T, D, W, WeightType>::IsEmpty(void) const
 	{
 		return vertices.empty();
 	}
 
-	template<class T>
-	Graph<T> &Graph<T>::operator=(const Graph<T> &otherGraph)
+	template<class T, Direction D, Weighting W, class WeightType>
+	Graph<T, D, W, WeightType> &Graph<T, D, W, WeightType>::operator=(const Graph<T, D, W, WeightType> &otherGraph)
 	{
 		if (this != &otherGraph)
 		{
+			Destroy();
 			this->direction = otherGraph.direction;
-			this->edgeCount = otherGraph.edgeCount;
-			this->vertexCount = otherGraph.vertexCount;
-			this->vertices = transform(otherGraph.vertices.begin(), otherGraph.vertices.end(), vertices.begin(), boost::lambda::bind(&(new Vertex<T>, boost::lambda::_1)));
 			this->weighting = otherGraph.weighting;
+			this->indexWeights = otherGraph.indexWeights;
+			CopyFrom(otherGraph);
 		}
 		return *this;
 	}
 
-	template<class T>
-	int Graph<T>::VertexCount(void) const
+	template<class T, Direction D, Weighting W, class WeightType>
+	Vertex<T, W, WeightType> * Graph<T, D, W, WeightType>::PlaceVertex(const Vertex<T, W, WeightType> &otherVertex)
+	{
+		Vertex<T, W, WeightType>	*vertex = new (arena.Allocate(sizeof(Vertex<T, W, WeightType>))) Vertex<T, W, WeightType>(otherVertex, arena);	// Our own copy of the vertex.
+
+		vertex->index = index.size();
+		vertex->IndexWeights(indexWeights);
+		index.push_back(vertex);
+		vertices.insert(vertex);
+		return vertex;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::ReleaseVertex(Vertex<T, W, WeightType> *vertex)
+	{
+		vertex->~Vertex<T, W, WeightType>();
+		arena.Deallocate(vertex, sizeof(Vertex<T, W, WeightType>));
+		return;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::CopyFrom(const Graph<T, D, W, WeightType> &otherGraph)
+	{
+		/*
+		Copy the data first so that every edge has somewhere to point.
+		*/
+		for (int i = 0; i < otherGraph.IndexCount(); i++)
+			if (otherGraph.index[i] == NULL)
+				index.push_back(NULL);
+			else
+				PlaceVertex(Vertex<T, W, WeightType>(otherGraph.index[i]->Get()));
+
+		for (int i = 0; i < otherGraph.IndexCount(); i++)
+			if (otherGraph.index[i] != NULL)
+				for (typename Vertex<T, W, WeightType>::EdgeIterator j = otherGraph.index[i]->EdgesBegin(); j != otherGraph.index[i]->EdgesEnd(); j++)
+					Link(*index[i], *index[boost::get<0>(*j)->Index()], Vertex<T, W, WeightType>::GetWeightFromTuple(*j));
+		edgeCount = otherGraph.edgeCount;
+		return;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::Link(Vertex<T, W, WeightType> &vertexA, Vertex<T, W, WeightType> &vertexB, const int weight)
+	{
+		vertexA.CreateNeighbor(vertexB, weight);
+		if (IsDirected())
+			vertexB.CreateInNeighbor(vertexA, weight);
+		return;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::Unlink(Vertex<T, W, WeightType> &vertexA, Vertex<T, W, WeightType> &vertexB)
+	{
+		vertexA.DeleteNeighbor(vertexB);
+		if (IsDirected())
+			vertexB.DeleteInNeighbor(vertexA);
+		return;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	typename Vertex<T, W, WeightType>::EdgeIterator Graph<T, D, W, WeightType>::InEdgesBegin(const Vertex<T, W, WeightType> &vertex) const
+	{
+		return IsDirected() ? vertex.inEdges.begin() : vertex.EdgesBegin();
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	typename Vertex<T, W, WeightType>::EdgeIterator Graph<T, D, W, WeightType>::InEdgesEnd(const Vertex<T, W, WeightType> &vertex) const
+	{
+		return IsDirected() ? vertex.inEdges.end() : vertex.EdgesEnd();
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	int Graph<T, D, W, WeightType>::InDegree(const Vertex<T, W, WeightType> &vertex) const
+	{
+		return IsDirected() ? vertex.inEdges.size() : vertex.Degree();
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	std::size_t Graph<T, D, W, WeightType>::Footprint(void) const
+	{
+		return arena.Footprint() + index.capacity() * sizeof(Vertex<T, W, WeightType>*);
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	const GraphStats &Graph<T, D, W, WeightType>::Stats(void) const
+	{
+		return stats;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::ResetStats(void)
+	{
+		stats.Reset();
+		return;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	int Graph<T, D, W, WeightType>::VertexCount(void) const
 	{
 		return vertices.size();
 	}
 
-	template<class T>
-	std::list<Vertex<T> &> Graph<T>::FindAll(boost::function<bool (const Vertex<T> &)> predicate)
+	template<class T, Direction D, Weighting W, class WeightType>
+	bool Graph<T, D, W, WeightType>::IsWeighted(void) const
+	{
+		return W == Weighted || (W == RuntimeWeighting && weighting == Weighted);
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	bool Graph<T, D, W, WeightType>::IsDirected(void) const
+	{
+		return D == Directed || (D == RuntimeDirection && direction == Directed);
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	int Graph<T, D, W, WeightType>::IndexCount(void) const
+	{
+		return index.size();
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	Vertex<T, W, WeightType> * Graph<T, D, W, WeightType>::VertexAt(int index) const
+	{
+		return this->index[index];
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::IndexWeights(bool enable)
+	{
+		indexWeights = enable;
+		for (typename VertexSet::iterator i = vertices.begin(); i != vertices.end(); i++)
+			(*i)->IndexWeights(enable);
+		return;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::Attach(GraphListener<T, W, WeightType> &listener)
+	{
+		listeners.push_back(&listener);
+		return;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::Detach(GraphListener<T, W, WeightType> &listener)
 	{
-		std::list<Vertex<T> &>	foundItems;	// The items we have found using the predicate provided.
+		listeners.remove(&listener);
+		return;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	std::list<Vertex<T, W, WeightType> &> Graph<T, D, W, WeightType>::FindAll(boost::function<bool (const Vertex<T, W, WeightType> &)> predicate)
+	{
+		std::list<Vertex<T, W, WeightType> &>	foundItems;	// The items we have found using the predicate provided.
 
-		for_each(vertices.begin(), vertices.end(), if_(predicate(boost::lambda::_1))[boost::lambda::bind(&std::list<Vertex<T> &>::push_back, foundItems, boost::lambda::_1)]);
+		for_each(vertices.begin(), vertices.end(), if_(predicate(boost::lambda::_1))[boost::lambda::bind(&std::list<Vertex<T, W, WeightType> &>::push_back, foundItems, boost::lambda::_1)]);
 
 		return foundItems;
 	}
 
-	template<class T>
-	Vertex<T> & Graph<T>::FindVertex(boost::function<bool (const Vertex<T> &)> predicate)
+	template<class T, Direction D, Weighting W, class WeightType>
+	Vertex<T, W, WeightType> & Graph<T, D, W, WeightType>::FindVertex(boost::function<bool (const Vertex<T, W, WeightType> &)> predicate)
 	{
-		return FindVertex(static_cast<boost::function<bool (const Vertex<T>*)> >(boost::lambda::bind(predicate, *boost::lambda::_1)));
+		return FindVertex(static_cast<boost::function<bool (const Vertex<T, W, WeightType>*)> >(boost::lambda::bind(predicate, *boost::lambda::_1)));
 	}
 
-	template<class T>
-	Vertex<T> & Graph<T>::FindVertex(boost::function<bool (const Vertex<T> *)> predicate)
+	template<class T, Direction D, Weighting W, class WeightType>
+	Vertex<T, W, WeightType> & Graph<T, D, W, WeightType>::FindVertex(boost::function<bool (const Vertex<T, W, WeightType> *)> predicate)
 	{
 		return **find_if(vertices.begin(), vertices.end(), predicate);
 	}
 
-	template<class T>
-	Vertex<T> & Graph<T>::Find(boost::function<bool (const T &)> predicate)
+	template<class T, Direction D, Weighting W, class WeightType>
+	Vertex<T, W, WeightType> & Graph<T, D, W, WeightType>::Find(boost::function<bool (const T &)> predicate)
 	{
-		return FindVertex(static_cast<boost::function<bool (const Vertex<T>*)> >(boost::lambda::bind(predicate, boost::lambda::bind(&Vertex<T>::Get, *boost::lambda::_1))));
+		return FindVertex(static_cast<boost::function<bool (const Vertex<T, W, WeightType>*)> >(boost::lambda::bind(predicate, boost::lambda::bind(&Vertex<T, W, WeightType>::Get, *boost::lambda::_1))));
 	}
 
-	template<class T>
-	std::ostream &operator <<(std::ostream &out, const Graph<T> &graph)
+	template<class T, Direction D, Weighting W, class WeightType>
+	std::ostream &operator <<(std::ostream &out, const Graph<T, D, W, WeightType> &graph)
 	{
 		return graph.Dump(out);
 	}
 
-	template<class T>
-	std::queue<Vertex<T>*> Graph<T>::ShortestPath(const Vertex<T> &vertexA, const Vertex<T> &vertexB)
+	template<class T, Direction D, Weighting W, class WeightType>
+	std::queue<Vertex<T, W, WeightType>*> Graph<T, D, W, WeightType>::ShortestPath(const Vertex<T, W, WeightType> &vertexA, const Vertex<T, W, WeightType> &vertexB)
+	{
+		return ShortestPath(vertexA, vertexB, searchState);
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	std::queue<Vertex<T, W, WeightType>*> Graph<T, D, W, WeightType>::ShortestPath(const Vertex<T, W, WeightType> &vertexA, const Vertex<T, W, WeightType> &vertexB, SearchState &searchState) const
 	{
-		using namespace boost::lambda;
-		using boost::function;
 		using namespace std;
 
-		list<Vertex<T>*>					shortestPathList,	// The found shortest path.
-											unvisitedNodes;		// The nodes we need to visit.
-		map<const Vertex<T>*, int>			distance;			// The distance map.
-		map<const Vertex<T>*, Vertex<T>*>	parents;			// The parent lookup list.
-		queue<Vertex<T>*>					shortestPath;		// The found shortest path (clean).
+		const int				source = vertexA.Index(),	// Where we start.
+								target = vertexB.Index();	// Where we're going.
+		list<Vertex<T, W, WeightType>*>		shortestPathList;			// The found shortest path.
+		queue<Vertex<T, W, WeightType>*>		shortestPath;				// The found shortest path (clean).
+		QueryTimer				timer(stats, searchState);	// Counts the query when it returns.
 
 		/*
-		Initialize the sources.
+		Only the source is reached to begin with.
 		*/
-		for_each
-		(
-			vertices.begin(), vertices.end(),
-			(
-				var(distance)[_1] = constant(Infinity),
-				var(parents)[_1] = constant(static_cast<Vertex<T>*>(NULL))
-			)
-		);
-		distance[&vertexA] = 0;
+		searchState.Reset(IndexCount());
+		if (!IsWeighted())
+		{
+			/*
+			Breadth first search: every edge is one hop, so the target's hop
+			count is final as soon as it's reached.
+			*/
+			searchState.Discover(source, -1);
+			for (int current = searchState.Next(); current != -1 && searchState.Distance(target) == Infinity; current = searchState.Next())
+				index[current]->ForEachEdge(Discovery<T, W, WeightType>(searchState, current));
+		}
+		else
+		{
+			searchState.Improve(source, 0, -1);
 
-		/*
-		Make the priority queue with all of our vertices in it.
-		*/
-		for_each
-		(
-			vertices.begin(), vertices.end(),
-			bind(&list<Vertex<T>*>::push_back, var(unvisitedNodes), _1)
-		);
+			/*
+			Dijkstra's Algorithm (modified to end when we settle the target):
+			*/
+			for (int current = searchState.Settle(); current != -1 && current != target; current = searchState.Settle())
+				index[current]->ForEachEdge(Relaxation<T, W, WeightType>(searchState, current));
+		}
 
 		/*
-		Dijkstra's Algorithm (modified to end when we hit the target:
+		Walk the parents back from the target; an unreached target yields an empty path.
 		*/
-		while (!unvisitedNodes.empty() && *min_element(unvisitedNodes.begin(), unvisitedNodes.end(), var(distance)[_1] < var(distance)[_2]) != &vertexB)
+		if (searchState.Distance(target) == Infinity)
+			return shortestPath;
+		for (int i = target; i != -1; i = searchState.Parent(i))
+			shortestPathList.push_front(index[i]);
+		for (typename list<Vertex<T, W, WeightType>*>::iterator i = shortestPathList.begin(); i != shortestPathList.end(); i++)
+			shortestPath.push(*i);
+		return shortestPath;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	std::queue<Vertex<T, W, WeightType>*> Graph<T, D, W, WeightType>::BidirectionalShortestPath(const Vertex<T, W, WeightType> &vertexA, const Vertex<T, W, WeightType> &vertexB)
+	{
+		return BidirectionalShortestPath(vertexA, vertexB, searchState, backwardState);
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	std::queue<Vertex<T, W, WeightType>*> Graph<T, D, W, WeightType>::BidirectionalShortestPath(const Vertex<T, W, WeightType> &vertexA, const Vertex<T, W, WeightType> &vertexB, SearchState &forward, SearchState &backward) const
+	{
+		using namespace std;
+
+		const int				source = vertexA.Index(),	// Where we start.
+								target = vertexB.Index();	// Where we're going.
+		list<Vertex<T, W, WeightType>*>		shortestPathList;			// The found shortest path.
+		queue<Vertex<T, W, WeightType>*>		shortestPath;				// The found shortest path (clean).
+		int						best = Infinity,			// Length of the shortest path seen so far.
+								meeting = -1;				// Where that path crosses from one search to the other.
+		QueryTimer				timer(stats, forward, &backward);	// Counts the query when it returns.
+
+		forward.Reset(IndexCount());
+		backward.Reset(IndexCount());
+		forward.Improve(source, 0, -1);
+		backward.Improve(target, 0, -1);
+		if (source == target)
 		{
-			Vertex<T> *current = *min_element(unvisitedNodes.begin(), unvisitedNodes.end(), var(distance)[_1] < var(distance)[_2]);
-			unvisitedNodes.remove(current);
-			shortestPathList.push_back(current);
-			list<Vertex<T>*>	neighbors = current->Neighbors();
-			for_each
-			(
-				neighbors.begin(),
-				neighbors.end(),
-				if_(
-					var(distance)[_1]
-						> (var(distance[current]) + bind(&Vertex<T>::GetWeight, var(current), *_1))
-				)
-				[
-					var(distance)[_1] = var(distance[current])
-						+ bind(&Vertex<T>::GetWeight, var(parents)[_1] = var(current), *_1)
-				]
-			);
+			shortestPath.push(index[source]);
+			return shortestPath;
 		}
-		shortestPathList.push_back(*min_element(unvisitedNodes.begin(), unvisitedNodes.end(), var(distance)[_1] < var(distance)[_2]));
 
 		/*
-		Remove extra crappy nodes.
+		Grow whichever search has the nearer frontier, as SearchRowsBidirectional()
+		does over a FrozenGraph. Once the two frontiers together are no nearer
+		than the best path, no unsettled vertex can lie on a shorter one.
 		*/
-		reverse(shortestPathList.begin(), shortestPathList.end());
-		for (typename list<Vertex<T>*>::iterator i = shortestPathList.begin(); *i != &vertexA;)
+		while (!forward.IsFrontierEmpty() && !backward.IsFrontierEmpty()
+			&& static_cast<long long>(forward.FrontierMinimum()) + backward.FrontierMinimum() < best)
 		{
-			if (parents[*i] != *(++i))
+			const bool	outward = forward.FrontierMinimum() <= backward.FrontierMinimum();	// Growing the forward search?
+			SearchState	&near = outward ? forward : backward,		// The search being grown.
+						&far = outward ? backward : forward;		// The other one.
+			const int	current = near.Settle();					// The vertex being settled.
+
+			if (current == -1)
+				break;
+
+			const int	currentDistance = near.Distance(current);	// Final in this search.
+			const typename Vertex<T, W, WeightType>::EdgeIterator	end = outward ? index[current]->EdgesEnd() : InEdgesEnd(*index[current]);	// Past the last edge to follow.
+
+			for (typename Vertex<T, W, WeightType>::EdgeIterator i = outward ? index[current]->EdgesBegin() : InEdgesBegin(*index[current]); i != end; i++)
 			{
-				shortestPathList.remove(*i);
-				i = shortestPathList.begin();
+				const int	next = boost::get<0>(*i)->Index();	// The far end of the edge.
+
+				near.Improve(next, currentDistance + (IsWeighted() ? boost::get<1>(*i) : 1), current);
+				if (far.Distance(next) != Infinity && static_cast<long long>(near.Distance(next)) + far.Distance(next) < best)
+				{
+					best = near.Distance(next) + far.Distance(next);
+					meeting = next;
+				}
 			}
 		}
-		reverse(shortestPathList.begin(), shortestPathList.end());
-		for_each
-		(
-			shortestPathList.begin(), shortestPathList.end(),
-			bind(&queue<Vertex<T>*>::push, var(shortestPath), _1)
-		);
+
+		/*
+		The forward parents lead back to the source, the backward ones on to the target.
+		*/
+		if (meeting == -1)
+			return shortestPath;
+		for (int i = meeting; i != -1; i = forward.Parent(i))
+			shortestPathList.push_front(index[i]);
+		for (int i = backward.Parent(meeting); i != -1; i = backward.Parent(i))
+			shortestPathList.push_back(index[i]);
+		for (typename list<Vertex<T, W, WeightType>*>::iterator i = shortestPathList.begin(); i != shortestPathList.end(); i++)
+			shortestPath.push(*i);
+		return shortestPath;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	template<class Heuristic>
+	std::queue<Vertex<T, W, WeightType>*> Graph<T, D, W, WeightType>::AStarShortestPath(const Vertex<T, W, WeightType> &vertexA, const Vertex<T, W, WeightType> &vertexB, Heuristic heuristic)
+	{
+		return AStarShortestPath(vertexA, vertexB, heuristic, searchState);
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	template<class Heuristic>
+	std::queue<Vertex<T, W, WeightType>*> Graph<T, D, W, WeightType>::AStarShortestPath(const Vertex<T, W, WeightType> &vertexA, const Vertex<T, W, WeightType> &vertexB, Heuristic heuristic, SearchState &searchState) const
+	{
+		using namespace std;
+
+		const int				source = vertexA.Index(),	// Where we start.
+								target = vertexB.Index();	// Where we're going.
+		list<Vertex<T, W, WeightType>*>		shortestPathList;			// The found shortest path.
+		queue<Vertex<T, W, WeightType>*>		shortestPath;				// The found shortest path (clean).
+		QueryTimer				timer(stats, searchState);	// Counts the query when it returns.
+
+		searchState.Reset(IndexCount());
+		searchState.Improve(source, 0, -1, heuristic(vertexA, vertexB));
+
+		/*
+		A* (ending when we settle the target, whose distance is then final):
+		*/
+		for (int current = searchState.Settle(); current != -1 && current != target; current = searchState.Settle())
+			index[current]->ForEachEdge(GuidedRelaxation<T, Heuristic, W, WeightType>(searchState, current, vertexB, heuristic, IsWeighted()));
+
+		/*
+		Walk the parents back from the target; an unreached target yields an empty path.
+		*/
+		if (!searchState.IsSettled(target))
+			return shortestPath;
+		for (int i = target; i != -1; i = searchState.Parent(i))
+			shortestPathList.push_front(index[i]);
+		for (typename list<Vertex<T, W, WeightType>*>::iterator i = shortestPathList.begin(); i != shortestPathList.end(); i++)
+			shortestPath.push(*i);
 		return shortestPath;
 	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	PathTree<T, W, WeightType> Graph<T, D, W, WeightType>::ShortestPathTree(const Vertex<T, W, WeightType> &source)
+	{
+		return ShortestPathTree(source, searchState);
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	PathTree<T, W, WeightType> Graph<T, D, W, WeightType>::ShortestPathTree(const Vertex<T, W, WeightType> &source, SearchState &searchState) const
+	{
+		QueryTimer	timer(stats, searchState);	// Counts the query when it returns.
+
+		/*
+		Dijkstra's Algorithm (or a breadth first search), run until everything reachable is settled.
+		*/
+		searchState.Reset(IndexCount());
+		if (!IsWeighted())
+		{
+			searchState.Discover(source.Index(), -1);
+			for (int current = searchState.Next(); current != -1; current = searchState.Next())
+				index[current]->ForEachEdge(Discovery<T, W, WeightType>(searchState, current));
+		}
+		else
+		{
+			searchState.Improve(source.Index(), 0, -1);
+			for (int current = searchState.Settle(); current != -1; current = searchState.Settle())
+				index[current]->ForEachEdge(Relaxation<T, W, WeightType>(searchState, current));
+		}
+		return PathTree<T, W, WeightType>(source.Index(), index, searchState);
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	std::vector<std::queue<Vertex<T, W, WeightType>*> > Graph<T, D, W, WeightType>::ShortestPaths(const std::vector<Query> &queries, ThreadPool &pool)
+	{
+		std::vector<std::queue<Vertex<T, W, WeightType>*> >	paths(queries.size());	// The answers.
+		boost::atomic<int>						next(0);				// The next unclaimed query.
+
+		if (static_cast<int>(workerStates.size()) < pool.Size())
+			workerStates.resize(pool.Size());
+		pool.Run(boost::bind(&Graph<T, D, W, WeightType>::AnswerQueries, this, boost::cref(queries), boost::ref(paths), boost::ref(next), boost::placeholders::_1));
+		return paths;
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	std::vector<std::queue<Vertex<T, W, WeightType>*> > Graph<T, D, W, WeightType>::ShortestPaths(const std::vector<Query> &queries)
+	{
+		if (!pool)
+			pool.reset(new ThreadPool());
+		return ShortestPaths(queries, *pool);
+	}
+
+	template<class T, Direction D, Weighting W, class WeightType>
+	void Graph<T, D, W, WeightType>::AnswerQueries(const std::vector<Query> &queries, std::vector<std::queue<Vertex<T, W, WeightType>*> > &paths, boost::atomic<int> &next, int worker)
+	{
+		/*
+		Claiming a few at a time keeps the counter from bouncing between cores
+		without leaving one worker stuck with all the long queries.
+		*/
+		const int	claim = 16;			// Queries claimed at once.
+		const int	count = queries.size();
+
+		for (int first = next.fetch_add(claim); first < count; first = next.fetch_add(claim))
+			for (int i = first; i < first + claim && i < count; i++)
+				paths[i] = ShortestPath(*queries[i].first, *queries[i].second, workerStates[worker]);
+		return;
+	}
 }
 
 #endif
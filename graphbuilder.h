@@ -0,0 +1,276 @@
+//
+// C++ Interface: graphbuilder
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHGRAPHBUILDER_H
+#define GRAPHGRAPHBUILDER_H
+
+#include <vector>
+#include <utility>
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/bind/bind.hpp>
+
+#include "graph.h"
+#include "threadpool.h"
+
+namespace Graphs
+{
+	/**
+	@class GraphBuilder graphbuilder.h
+	@brief Lets many threads insert vertices and edges at once, then hands them all to a Graph.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	The Graph's vertex set, edge lists and Arena are for one thread at a
+	time. A GraphBuilder gives each loader thread a staging area of its own,
+	so threads reading different shards of the input never share anything
+	but one atomic counter: InsertVertex() takes the next identifier from it
+	without a lock and files the data locally, and InsertEdge() only appends
+	to the thread's own buffer. The staging areas are kept on separate cache
+	lines so the threads don't slow each other down either.
+
+	Finish(), called once the threads are done, places the staged vertices
+	in identifier order (so each gets the identifier InsertVertex() promised)
+	and then links every staged edge, each vertex's edges laid down together.
+	Checking the edges, mirroring them for an Undirected Graph and counting
+	sort by source is done by one worker per stage, in parallel; only the
+	prefix sum over the counts (one pass per stage over the identifiers),
+	the vertices' placement and the linking itself, which allocates from
+	the Graph's Arena, are left to a single thread. So parsing and sorting
+	scale with the threads, and the serial remainder is one pass over the
+	grouped edges that touches memory in order.
+
+	Nothing else may insert vertices into the Graph between constructing the
+	builder (or the last Finish()) and Finish(), or the promised identifiers
+	would be taken.
+	*/
+	template<class T>
+	class GraphBuilder
+	{
+		public:
+			/**
+			@param graph The Graph to build into.
+			@param threads The number of loader threads, numbered 0 through threads - 1.
+
+			Constructor
+			*/
+			GraphBuilder(Graph<T> &graph, int threads);
+
+			/**
+			@param thread The caller's number.
+			@param vertices The vertices the thread expects to insert.
+			@param edges The edges the thread expects to insert.
+
+			Size the thread's staging area up front.
+			*/
+			void Reserve(int thread, int vertices, int edges);
+
+			/**
+			@param thread The caller's number.
+			@param data The data the new vertex should hold.
+			@return The dense identifier the vertex will have in the Graph.
+			*/
+			int InsertVertex(int thread, const T &data);
+
+			/**
+			@param thread The caller's number.
+			@param from The dense identifier of the edge's start (in the Graph already, or promised by InsertVertex()).
+			@param to The dense identifier of the edge's end.
+			@param weight The weight of the edge.
+
+			An edge naming an identifier that is neither in the Graph nor handed out is dropped by Finish().
+			*/
+			void InsertEdge(int thread, int from, int to, int weight = 1);
+
+			/**
+			Move everything staged into the Graph. Only call it once every loader thread has stopped.
+			*/
+			void Finish(void);
+
+		private:
+			typedef typename Graph<T>::EdgeTriple	EdgeTriple;	//!< Source identifier, destination identifier and weight of an edge.
+
+			/**
+			@brief One thread's vertices and edges, alone on its cache line.
+			*/
+			struct Stage
+			{
+				std::vector<std::pair<int, T> >	vertices;	//!< Identifiers handed out and the data for them.
+				std::vector<EdgeTriple>			edges;		//!< The edges inserted (and, in Finish(), their mirror images).
+				std::vector<int>				offsets;	//!< Where, in Finish(), this stage's edges from each source go.
+				std::size_t						given;		//!< The edges kept by Finish(), ahead of any mirror images.
+				char							padding[64];	//!< Keeps the next thread's vectors off this line.
+
+				/**
+				Constructor
+				*/
+				Stage(void);
+			};
+
+			Graph<T>					&graph;		//!< The Graph being built.
+			int							threads;	//!< The number of loader threads.
+			boost::scoped_array<Stage>	stages;		//!< Each thread's staging area.
+			boost::atomic<int>			next;		//!< The next identifier to hand out.
+			int							base;		//!< The Graph's IndexCount() when the identifiers were counted from.
+			ThreadPool					pool;		//!< One worker per stage, for Finish().
+
+			/**
+			@param worker The stage to sort.
+
+			Drop the stage's edges naming missing vertices, mirror the rest if the Graph is Undirected and count them by source.
+			*/
+			void CountStage(int worker);
+
+			/**
+			@param grouped Where every stage's edges go, grouped by source.
+			@param worker The stage to place.
+			*/
+			void PlaceStage(std::vector<EdgeTriple> &grouped, int worker);
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			GraphBuilder(const GraphBuilder &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			GraphBuilder &operator=(const GraphBuilder &);
+	};
+
+	template<class T>
+	GraphBuilder<T>::Stage::Stage(void)
+	:vertices(std::vector<std::pair<int, T> >()), edges(std::vector<EdgeTriple>()), offsets(std::vector<int>()), given(0), padding()
+	{
+	}
+
+	template<class T>
+	GraphBuilder<T>::GraphBuilder(Graph<T> &graph, int threads)
+	:graph(graph), threads(threads > 0 ? threads : 1), stages(new Stage[threads > 0 ? threads : 1]), next(graph.IndexCount()), base(graph.IndexCount()), pool(threads > 0 ? threads : 1)
+	{
+	}
+
+	template<class T>
+	void GraphBuilder<T>::Reserve(int thread, int vertices, int edges)
+	{
+		stages[thread].vertices.reserve(stages[thread].vertices.size() + vertices);
+		stages[thread].edges.reserve(stages[thread].edges.size() + edges);
+		return;
+	}
+
+	template<class T>
+	int GraphBuilder<T>::InsertVertex(int thread, const T &data)
+	{
+		const int	identifier = next.fetch_add(1, boost::memory_order_relaxed);	// Ours alone.
+
+		stages[thread].vertices.push_back(std::make_pair(identifier, data));
+		return identifier;
+	}
+
+	template<class T>
+	void GraphBuilder<T>::InsertEdge(int thread, int from, int to, int weight)
+	{
+		stages[thread].edges.push_back(EdgeTriple(from, to, weight));
+		return;
+	}
+
+	template<class T>
+	void GraphBuilder<T>::Finish(void)
+	{
+		const int						count = next.load() - base;	// Vertices staged.
+		std::vector<const T*>			data(count, static_cast<const T*>(NULL));	// Each staged vertex's data by identifier.
+		std::vector<EdgeTriple>			grouped;					// Every staged edge, grouped by source.
+		int								total = 0;					// Edges to link.
+
+		/*
+		Every identifier handed out was filed by exactly one thread, so
+		placing them in order gives each the identifier it was promised.
+		*/
+		for (int i = 0; i < threads; i++)
+			for (typename std::vector<std::pair<int, T> >::const_iterator j = stages[i].vertices.begin(); j != stages[i].vertices.end(); j++)
+				data[j->first - base] = &j->second;
+		graph.Reserve(count, 0);
+		for (int i = 0; i < count; i++)
+			graph.InsertNewVertex(*data[i]);
+
+		/*
+		Each stage counts its edges by source, then the running total over
+		sources, and over the stages within a source, says where each
+		stage's edges from that source start; each stage then moves its
+		edges there, in the order they were inserted.
+		*/
+		pool.Run(boost::bind(&GraphBuilder<T>::CountStage, this, boost::placeholders::_1));
+		for (int source = 0; source < graph.IndexCount(); source++)
+			for (int i = 0; i < threads; i++)
+			{
+				const int	edges = stages[i].offsets[source];	// This stage's edges from source.
+
+				stages[i].offsets[source] = total;
+				total += edges;
+			}
+		grouped.resize(total);
+		pool.Run(boost::bind(&GraphBuilder<T>::PlaceStage, this, boost::ref(grouped), boost::placeholders::_1));
+
+		graph.LinkGrouped(grouped);
+		for (int i = 0; i < threads; i++)
+		{
+			graph.EdgesLinked(stages[i].edges.begin(), stages[i].edges.begin() + stages[i].given);
+			std::vector<std::pair<int, T> >().swap(stages[i].vertices);
+			std::vector<EdgeTriple>().swap(stages[i].edges);
+			std::vector<int>().swap(stages[i].offsets);
+		}
+
+		base = graph.IndexCount();
+		next.store(base);
+		return;
+	}
+
+	template<class T>
+	void GraphBuilder<T>::CountStage(int worker)
+	{
+		Stage						&stage = stages[worker];	// Ours alone.
+		const int					vertices = graph.IndexCount();	// Identifiers in use.
+		std::size_t					kept = 0;					// Edges that name live vertices.
+
+		for (typename std::vector<EdgeTriple>::const_iterator i = stage.edges.begin(); i != stage.edges.end(); i++)
+		{
+			const int	source = boost::get<0>(*i),
+						destination = boost::get<1>(*i);
+
+			if (source >= 0 && source < vertices && graph.VertexAt(source) != NULL && destination >= 0 && destination < vertices && graph.VertexAt(destination) != NULL)
+				stage.edges[kept++] = *i;
+		}
+		stage.edges.resize(kept);
+		stage.given = kept;
+		if (!graph.IsDirected())
+		{
+			stage.edges.reserve(2 * kept);
+			for (std::size_t i = 0; i < kept; i++)
+				stage.edges.push_back(EdgeTriple(boost::get<1>(stage.edges[i]), boost::get<0>(stage.edges[i]), boost::get<2>(stage.edges[i])));
+		}
+
+		stage.offsets.assign(vertices, 0);
+		for (typename std::vector<EdgeTriple>::const_iterator i = stage.edges.begin(); i != stage.edges.end(); i++)
+			stage.offsets[boost::get<0>(*i)]++;
+		return;
+	}
+
+	template<class T>
+	void GraphBuilder<T>::PlaceStage(std::vector<EdgeTriple> &grouped, int worker)
+	{
+		Stage	&stage = stages[worker];	// Ours alone.
+
+		for (typename std::vector<EdgeTriple>::const_iterator i = stage.edges.begin(); i != stage.edges.end(); i++)
+			grouped[stage.offsets[boost::get<0>(*i)]++] = *i;
+		return;
+	}
+}
+
+#endif
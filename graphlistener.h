@@ -0,0 +1,109 @@
+//
+// C++ Interface: graphlistener
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHLISTENER_H
+#define GRAPHLISTENER_H
+
+#include "vertex.h"
+
+namespace Graphs
+{
+	/**
+	@class GraphListener graphlistener.h
+	@brief Something that needs to hear about changes to a Graph.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Attach one to a Graph and it is told about every change as it happens,
+	which is how indexes and caches built on top of a Graph stay in sync.
+	Override only the events you care about.
+	*/
+	template<class T, Weighting W = RuntimeWeighting, class WeightType = int>
+	class GraphListener
+	{
+		public:
+			/**
+			Destructor
+			*/
+			virtual ~GraphListener(void);
+
+			/**
+			@param vertex The vertex that was just inserted.
+			*/
+			virtual void VertexInserted(Vertex<T, W, WeightType> &vertex);
+
+			/**
+			@param vertex The vertex about to be deleted.
+			*/
+			virtual void VertexDeleted(const Vertex<T, W, WeightType> &vertex);
+
+			/**
+			@param from Where the new edge starts.
+			@param to Where the new edge ends.
+			@param weight The weight of the new edge.
+
+			In an Undirected Graph the edge runs both ways but is only reported once.
+			*/
+			virtual void EdgeInserted(Vertex<T, W, WeightType> &from, Vertex<T, W, WeightType> &to, int weight);
+
+			/**
+			@param from Where the deleted edges started.
+			@param to Where the deleted edges ended.
+
+			Edges that go with a deleted vertex are covered by VertexDeleted() instead.
+			*/
+			virtual void EdgeDeleted(Vertex<T, W, WeightType> &from, Vertex<T, W, WeightType> &to);
+
+			/**
+			@param from Where the edge starts.
+			@param to Where the edge ends.
+			@param oldWeight The weight it had.
+			@param newWeight The weight it has now.
+			*/
+			virtual void WeightChanged(Vertex<T, W, WeightType> &from, Vertex<T, W, WeightType> &to, int oldWeight, int newWeight);
+	};
+
+	template<class T, Weighting W, class WeightType>
+	GraphListener<T, W, WeightType>::~GraphListener(void)
+	{
+	}
+
+	template<class T, Weighting W, class WeightType>
+	void GraphListener<T, W, WeightType>::VertexInserted(Vertex<T, W, WeightType> &)
+	{
+		return;
+	}
+
+	template<class T, Weighting W, class WeightType>
+	void GraphListener<T, W, WeightType>::VertexDeleted(const Vertex<T, W, WeightType> &)
+	{
+		return;
+	}
+
+	template<class T, Weighting W, class WeightType>
+	void GraphListener<T, W, WeightType>::EdgeInserted(Vertex<T, W, WeightType> &, Vertex<T, W, WeightType> &, int)
+	{
+		return;
+	}
+
+	template<class T, Weighting W, class WeightType>
+	void GraphListener<T, W, WeightType>::EdgeDeleted(Vertex<T, W, WeightType> &, Vertex<T, W, WeightType> &)
+	{
+		return;
+	}
+
+	template<class T, Weighting W, class WeightType>
+	void GraphListener<T, W, WeightType>::WeightChanged(Vertex<T, W, WeightType> &, Vertex<T, W, WeightType> &, int, int)
+	{
+		return;
+	}
+}
+
+#endif
@@ -0,0 +1,141 @@
+//
+// C++ Interface: keyindex
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHKEYINDEX_H
+#define GRAPHKEYINDEX_H
+
+#include <boost/unordered_map.hpp>
+
+#include "graph.h"
+#include "graphlistener.h"
+
+namespace Graphs
+{
+	/**
+	@brief Key extractor that uses the whole payload as the key.
+	*/
+	template<class T>
+	struct Identity
+	{
+		/**
+		@param data The payload.
+		@return The payload.
+		*/
+		const T &operator()(const T &data) const
+		{
+			return data;
+		}
+	};
+
+	/**
+	@class KeyIndex keyindex.h
+	@brief Hash from a key of each vertex's data to the vertex.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Resolves a vertex by key in constant time instead of scanning the Graph
+	with Find(). The index listens to the Graph, so inserted and deleted
+	vertices are picked up as they happen; changing a vertex's data with
+	Vertex::Set() is not noticed. Keys should be unique; if they aren't, the
+	first vertex inserted with a key is the one found.
+	*/
+	template<class T, class Key = T, class KeyOf = Identity<T> >
+	class KeyIndex : public GraphListener<T>
+	{
+		public:
+			/**
+			@param graph The Graph to index.
+			@param keyOf Functor that takes a vertex's data to its key.
+
+			Constructor
+			*/
+			explicit KeyIndex(Graph<T> &graph, KeyOf keyOf = KeyOf());
+
+			/**
+			Destructor
+			*/
+			~KeyIndex(void);
+
+			/**
+			@param key The key to look for.
+			@return The vertex with that key, or NULL if there isn't one.
+			*/
+			Vertex<T> * Lookup(const Key &key) const;
+
+			/**
+			@param vertex The vertex that was just inserted.
+			*/
+			void VertexInserted(Vertex<T> &vertex);
+
+			/**
+			@param vertex The vertex about to be deleted.
+			*/
+			void VertexDeleted(const Vertex<T> &vertex);
+
+		private:
+			Graph<T>							&graph;		//!< The Graph being indexed.
+			KeyOf								keyOf;		//!< Takes data to keys.
+			boost::unordered_map<Key, Vertex<T>*>	vertices;	//!< The vertices by key.
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			KeyIndex(const KeyIndex &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			KeyIndex &operator=(const KeyIndex &);
+	};
+
+	template<class T, class Key, class KeyOf>
+	KeyIndex<T, Key, KeyOf>::KeyIndex(Graph<T> &graph, KeyOf keyOf)
+	:GraphListener<T>(), graph(graph), keyOf(keyOf), vertices(boost::unordered_map<Key, Vertex<T>*>())
+	{
+		vertices.reserve(graph.VertexCount());
+		for (int i = 0; i < graph.IndexCount(); i++)
+			if (graph.VertexAt(i) != NULL)
+				VertexInserted(*graph.VertexAt(i));
+		graph.Attach(*this);
+	}
+
+	template<class T, class Key, class KeyOf>
+	KeyIndex<T, Key, KeyOf>::~KeyIndex(void)
+	{
+		graph.Detach(*this);
+	}
+
+	template<class T, class Key, class KeyOf>
+	Vertex<T> * KeyIndex<T, Key, KeyOf>::Lookup(const Key &key) const
+	{
+		typename boost::unordered_map<Key, Vertex<T>*>::const_iterator found = vertices.find(key);
+
+		return found == vertices.end() ? NULL : found->second;
+	}
+
+	template<class T, class Key, class KeyOf>
+	void KeyIndex<T, Key, KeyOf>::VertexInserted(Vertex<T> &vertex)
+	{
+		vertices.insert(std::make_pair(Key(keyOf(vertex.Get())), &vertex));
+		return;
+	}
+
+	template<class T, class Key, class KeyOf>
+	void KeyIndex<T, Key, KeyOf>::VertexDeleted(const Vertex<T> &vertex)
+	{
+		typename boost::unordered_map<Key, Vertex<T>*>::iterator found = vertices.find(keyOf(vertex.Get()));
+
+		if (found != vertices.end() && found->second == &vertex)
+			vertices.erase(found);
+		return;
+	}
+}
+
+#endif
@@ -0,0 +1,388 @@
+//
+// C++ Interface: loader
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHLOADER_H
+#define GRAPHLOADER_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
+
+#include "graph.h"
+#include "mappedfile.h"
+
+namespace Graphs
+{
+	/**
+	@class Loader loader.h
+	@brief Reads graphs from edge list and DIMACS files.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	The file is memory mapped and scanned with a hand-rolled integer parser,
+	and the edges are handed to Graph::InsertEdges() in large batches. Each
+	vertex's data is constructed from the vertex number used in the file, so
+	T must be constructible from an int.
+
+	Edge lists have one edge per line: the source, the destination and an
+	optional weight (1 if missing), separated by blanks or commas. Vertex
+	numbers are non-negative and should be reasonably dense. Lines starting
+	with '#' or '%' are comments. Numbers past MaxNumber are rejected, since
+	the vertex numbers index a table.
+
+	DIMACS shortest path files (.gr) have a "p sp <vertices> <arcs>" line
+	followed by "a <source> <destination> <weight>" lines, with vertices
+	numbered from 1. Lines starting with 'c' are comments.
+
+	Negative weights are rejected in either format; every search assumes
+	there are none.
+
+	A load that fails part way leaves whatever it had already inserted in
+	the Graph.
+	*/
+	template<class T>
+	class Loader
+	{
+		public:
+			/**
+			@param graph The Graph to load into.
+
+			Constructor
+			*/
+			explicit Loader(Graph<T> &graph);
+
+			/**
+			@param path The edge list file.
+			@return True if the file was loaded; otherwise false (see Error()).
+			*/
+			bool LoadEdgeList(const std::string &path);
+
+			/**
+			@param path The DIMACS file.
+			@return True if the file was loaded; otherwise false (see Error()).
+			*/
+			bool LoadDimacs(const std::string &path);
+
+			/**
+			@return The vertex the file called number, or NULL if it didn't mention it.
+			*/
+			Vertex<T> * VertexFor(int number) const;
+
+			/**
+			@return What went wrong with the last load (empty if nothing did).
+			*/
+			const std::string &Error(void) const;
+
+		private:
+			static const int	BatchSize = 1 << 20;	//!< Edges parsed before they're handed to the Graph.
+			static const int	MaxNumber = 100000000;	//!< The largest vertex number (or DIMACS vertex count) accepted.
+
+			Graph<T>								&graph;		//!< Where the vertices and edges go.
+			std::vector<int>						numbers;	//!< Dense identifiers by file vertex number (-1 if unseen).
+			std::vector<typename Graph<T>::EdgeTriple>	batch;		//!< Edges parsed but not yet inserted.
+			std::string								error;		//!< What went wrong with the last load.
+			const char								*cursor;	//!< Where the scanner is.
+			const char								*end;		//!< The end of the file.
+			int										line;		//!< The line the scanner is on.
+
+			/**
+			@param path The file to scan.
+			@param file The mapping to set up.
+			@return True if the file could be mapped.
+			*/
+			bool Begin(const std::string &path, MappedFile &file);
+
+			/**
+			Skip blanks and commas, stopping at the end of the line.
+			*/
+			void SkipBlanks(void);
+
+			/**
+			Skip past the end of the current line.
+			*/
+			void SkipLine(void);
+
+			/**
+			@return True if the scanner is at the end of a line (or the file).
+			*/
+			bool AtEndOfLine(void) const;
+
+			/**
+			@param value Where to put the integer.
+			@return True if an integer was read (false if there wasn't one, or it doesn't fit in an int).
+			*/
+			bool ReadInteger(int &value);
+
+			/**
+			@param message What's wrong (ignored if something already failed, since the first message is the most specific).
+			@return False, so the error can be returned directly.
+			*/
+			bool Fail(const std::string &message);
+
+			/**
+			@param number The vertex number used in the file.
+			@return The dense identifier, inserting the vertex on first sight.
+			*/
+			int Identifier(int number);
+
+			/**
+			Hand the batch to the Graph.
+			*/
+			void Flush(void);
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			Loader(const Loader &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			Loader &operator=(const Loader &);
+	};
+
+	template<class T>
+	Loader<T>::Loader(Graph<T> &graph)
+	:graph(graph), numbers(std::vector<int>()), batch(std::vector<typename Graph<T>::EdgeTriple>()), error(std::string()), cursor(NULL), end(NULL), line(0)
+	{
+	}
+
+	template<class T>
+	bool Loader<T>::LoadEdgeList(const std::string &path)
+	{
+		MappedFile	file;	// The edge list.
+
+		if (!Begin(path, file))
+			return false;
+
+		while (cursor != end)
+		{
+			int	source,			// Vertex number of the source.
+				destination,	// Vertex number of the destination.
+				weight = 1;		// Weight of the edge.
+
+			SkipBlanks();
+			if (AtEndOfLine() || *cursor == '#' || *cursor == '%')
+			{
+				SkipLine();
+				continue;
+			}
+			if (!ReadInteger(source) || !ReadInteger(destination))
+				return Fail("expected a source and a destination");
+			if (source < 0 || destination < 0)
+				return Fail("vertex numbers can't be negative");
+			if (source > MaxNumber || destination > MaxNumber)
+				return Fail("vertex number too large");
+			SkipBlanks();
+			if (!AtEndOfLine() && !ReadInteger(weight))
+				return Fail("expected a weight");
+			if (weight < 0)
+				return Fail("weights can't be negative");
+			SkipBlanks();
+			if (!AtEndOfLine())
+				return Fail("unexpected text after the edge");
+			SkipLine();
+
+			batch.push_back(typename Graph<T>::EdgeTriple(Identifier(source), Identifier(destination), weight));
+			if (static_cast<int>(batch.size()) == BatchSize)
+				Flush();
+		}
+		Flush();
+		return true;
+	}
+
+	template<class T>
+	bool Loader<T>::LoadDimacs(const std::string &path)
+	{
+		MappedFile	file;			// The DIMACS file.
+		int			vertices = -1,	// Vertex count from the problem line.
+					arcs = -1;		// Arc count from the problem line.
+
+		if (!Begin(path, file))
+			return false;
+
+		while (cursor != end)
+		{
+			SkipBlanks();
+			if (AtEndOfLine() || *cursor == 'c')
+			{
+				SkipLine();
+				continue;
+			}
+
+			if (*cursor == 'p')
+			{
+				cursor++;
+				SkipBlanks();
+				if (end - cursor < 2 || cursor[0] != 's' || cursor[1] != 'p')
+					return Fail("expected a shortest path (sp) problem line");
+				cursor += 2;
+				if (vertices != -1)
+					return Fail("more than one problem line");
+				if (!ReadInteger(vertices) || !ReadInteger(arcs) || vertices < 0 || arcs < 0)
+					return Fail("expected vertex and arc counts");
+				if (vertices > MaxNumber)
+					return Fail("too many vertices");
+
+				/*
+				DIMACS numbers every vertex up front, so they all go in now, in
+				order. An arc line takes at least eight bytes, so a count larger
+				than the rest of the file could hold isn't believed.
+				*/
+				graph.Reserve(vertices, static_cast<int>(std::min<std::ptrdiff_t>(arcs, (end - cursor) / 8)));
+				for (int i = 1; i <= vertices; i++)
+					Identifier(i);
+			}
+			else if (*cursor == 'a')
+			{
+				int	source,			// Vertex number of the source.
+					destination,	// Vertex number of the destination.
+					weight;			// Weight of the arc.
+
+				cursor++;
+				if (vertices == -1)
+					return Fail("arc before the problem line");
+				if (!ReadInteger(source) || !ReadInteger(destination) || !ReadInteger(weight))
+					return Fail("expected a source, a destination and a weight");
+				if (source < 1 || source > vertices || destination < 1 || destination > vertices)
+					return Fail("vertex number out of range");
+				if (weight < 0)
+					return Fail("weights can't be negative");
+				batch.push_back(typename Graph<T>::EdgeTriple(numbers[source], numbers[destination], weight));
+				if (static_cast<int>(batch.size()) == BatchSize)
+					Flush();
+			}
+			else
+				return Fail("unknown line type");
+
+			SkipBlanks();
+			if (!AtEndOfLine())
+				return Fail("unexpected text at the end of the line");
+			SkipLine();
+		}
+		Flush();
+		return true;
+	}
+
+	template<class T>
+	Vertex<T> * Loader<T>::VertexFor(int number) const
+	{
+		if (number < 0 || number >= static_cast<int>(numbers.size()) || numbers[number] == -1)
+			return NULL;
+		return graph.VertexAt(numbers[number]);
+	}
+
+	template<class T>
+	const std::string &Loader<T>::Error(void) const
+	{
+		return error;
+	}
+
+	template<class T>
+	bool Loader<T>::Begin(const std::string &path, MappedFile &file)
+	{
+		error.clear();
+		batch.clear();
+		line = 0;
+		if (!file.Open(path))
+			return Fail("can't open " + path);
+		cursor = file.Begin();
+		end = file.End();
+		line = 1;
+		return true;
+	}
+
+	template<class T>
+	void Loader<T>::SkipBlanks(void)
+	{
+		while (cursor != end && (*cursor == ' ' || *cursor == '\t' || *cursor == ',' || *cursor == '\r'))
+			cursor++;
+		return;
+	}
+
+	template<class T>
+	void Loader<T>::SkipLine(void)
+	{
+		while (cursor != end && *cursor != '\n')
+			cursor++;
+		if (cursor != end)
+		{
+			cursor++;
+			line++;
+		}
+		return;
+	}
+
+	template<class T>
+	bool Loader<T>::AtEndOfLine(void) const
+	{
+		return cursor == end || *cursor == '\n';
+	}
+
+	template<class T>
+	bool Loader<T>::ReadInteger(int &value)
+	{
+		bool	negative = false;	// Was there a minus sign?
+
+		SkipBlanks();
+		if (cursor != end && (*cursor == '-' || *cursor == '+'))
+			negative = *cursor++ == '-';
+		if (cursor == end || *cursor < '0' || *cursor > '9')
+			return false;
+
+		for (value = 0; cursor != end && *cursor >= '0' && *cursor <= '9'; cursor++)
+		{
+			if (value > (std::numeric_limits<int>::max() - (*cursor - '0')) / 10)
+				return Fail("number too large");
+			value = value * 10 + (*cursor - '0');
+		}
+		if (negative)
+			value = -value;
+		return true;
+	}
+
+	template<class T>
+	bool Loader<T>::Fail(const std::string &message)
+	{
+		std::ostringstream	out;	// The message with its line number.
+
+		if (!error.empty())
+			return false;
+		if (line > 0)
+			out << "line " << line << ": ";
+		out << message;
+		error = out.str();
+		batch.clear();
+		return false;
+	}
+
+	template<class T>
+	int Loader<T>::Identifier(int number)
+	{
+		if (number >= static_cast<int>(numbers.size()))
+			numbers.resize(number + 1, -1);
+		if (numbers[number] == -1)
+			numbers[number] = graph.InsertNewVertex(T(number)).Index();
+		return numbers[number];
+	}
+
+	template<class T>
+	void Loader<T>::Flush(void)
+	{
+		graph.InsertEdges(batch.begin(), batch.end());
+		batch.clear();
+		return;
+	}
+}
+
+#endif
@@ -36,6 +36,7 @@ These should be an enum (Keyword) type so the following declarations are valid s
 	- Graph&lt;Something&gt;   graph(Directed);\n
 	- Graph&lt;Something&gt;   graph(Weighted);\n
 	- Graph&lt;AnotherType&gt; graph;\n
+	- Graph&lt;City, Directed, Weighted&gt; map;\n (the same choice, made at compile time)
 	- etc.
 	.
 
@@ -79,6 +80,8 @@ If bugs are found please email Alex Brandt <alunduil@alunduil.com> with a bugrep
 #include <iostream>
 
 #include "graph.h"
+#include "frozengraph.h"
+#include "keyindex.h"
 
 using namespace Graphs;
 using namespace std;
@@ -136,6 +139,15 @@ int main(void)
 
 	cout << map << endl;
 
+	/*
+	The map doesn't change from here on, so query a compacted snapshot of it.
+	*/
+
+	FrozenGraph<string>		frozenMap(map);				//!< Read-only copy of the map for lookups.
+	KeyIndex<string>		cities(map);				//!< The cities by name.
+	Vertex<string>			*source,					//!< Source vertex.
+							*destination;				//!< Destination vertex.
+
 	cout << "Shortest Pathing Program 1.0" << endl;
 	cout << "Copyright (C) 2007 Alex Brandt" << endl;
 	cout << "ShortestPath is a small utility that allows simple lookups to be performed on a" << endl;
@@ -160,13 +172,28 @@ int main(void)
 			return 0;
 
 		/*
-		Get the shortest path.
+		Look the cities up, and get the shortest path.
 		*/
-		shortestPath = map.ShortestPath(map.Find(_1 == var(sourceCity)), map.Find(_1 == var(destinationCity)));
+		if ((source = cities.Lookup(sourceCity)) == NULL)
+		{
+			cout << "There is no city named " << sourceCity << " on the map." << endl;
+			continue;
+		}
+		if ((destination = cities.Lookup(destinationCity)) == NULL)
+		{
+			cout << "There is no city named " << destinationCity << " on the map." << endl;
+			continue;
+		}
+		shortestPath = frozenMap.BidirectionalShortestPath(*source, *destination);
 
 		/*
 		Output the shortest path.
 		*/
+		if (shortestPath.empty())
+		{
+			cout << "There is no path from " << sourceCity << " to " << destinationCity << "." << endl;
+			continue;
+		}
 		while (shortestPath.size() > 1)
 		{
 			cout << shortestPath.front()->Get() << " -> ";
@@ -0,0 +1,155 @@
+//
+// C++ Interface: mappedfile
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHMAPPEDFILE_H
+#define GRAPHMAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Graphs
+{
+	/**
+	@class MappedFile mappedfile.h
+	@brief Read-only memory map of a whole file.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	The file's bytes are read straight out of the page cache, with no copy
+	into our own buffers, and processes mapping the same file share them.
+	*/
+	class MappedFile
+	{
+		public:
+			/**
+			Constructor
+			*/
+			MappedFile(void);
+
+			/**
+			Destructor
+			*/
+			~MappedFile(void);
+
+			/**
+			@param path The file to map.
+			@param sequential Whether the file will be read front to back (tells the kernel to read ahead).
+			@return True if the file is mapped; otherwise false.
+			*/
+			bool Open(const std::string &path, bool sequential = true);
+
+			/**
+			Unmap the file.
+			*/
+			void Close(void);
+
+			/**
+			@return The first byte of the file.
+			*/
+			const char *Begin(void) const;
+
+			/**
+			@return One past the last byte of the file.
+			*/
+			const char *End(void) const;
+
+			/**
+			@return The size of the file in bytes.
+			*/
+			std::size_t Size(void) const;
+
+		private:
+			int			descriptor;	//!< The open file (-1 if none).
+			void		*data;		//!< The mapping (NULL if none).
+			std::size_t	size;		//!< The size of the mapping.
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			MappedFile(const MappedFile &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			MappedFile &operator=(const MappedFile &);
+	};
+
+	inline MappedFile::MappedFile(void)
+	:descriptor(-1), data(NULL), size(0)
+	{
+	}
+
+	inline MappedFile::~MappedFile(void)
+	{
+		Close();
+	}
+
+	inline bool MappedFile::Open(const std::string &path, bool sequential)
+	{
+		struct stat	status;	// The size of the file.
+
+		Close();
+		if ((descriptor = open(path.c_str(), O_RDONLY)) == -1)
+			return false;
+		if (fstat(descriptor, &status) == -1)
+		{
+			Close();
+			return false;
+		}
+
+		/*
+		An empty file can't be mapped, but it's still a perfectly good file.
+		*/
+		if ((size = status.st_size) == 0)
+			return true;
+		if ((data = mmap(NULL, size, PROT_READ, MAP_SHARED, descriptor, 0)) == MAP_FAILED)
+		{
+			data = NULL;
+			Close();
+			return false;
+		}
+		if (sequential)
+			madvise(data, size, MADV_SEQUENTIAL);
+		return true;
+	}
+
+	inline void MappedFile::Close(void)
+	{
+		if (data != NULL)
+			munmap(data, size);
+		if (descriptor != -1)
+			close(descriptor);
+		descriptor = -1;
+		data = NULL;
+		size = 0;
+		return;
+	}
+
+	inline const char *MappedFile::Begin(void) const
+	{
+		return static_cast<const char*>(data);
+	}
+
+	inline const char *MappedFile::End(void) const
+	{
+		return static_cast<const char*>(data) + size;
+	}
+
+	inline std::size_t MappedFile::Size(void) const
+	{
+		return size;
+	}
+}
+
+#endif
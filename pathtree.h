@@ -0,0 +1,131 @@
+//
+// C++ Interface: pathtree
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHPATHTREE_H
+#define GRAPHPATHTREE_H
+
+#include <vector>
+#include <list>
+#include <queue>
+
+#include "vertex.h"
+#include "searchstate.h"
+
+namespace Graphs
+{
+	/**
+	@class PathTree pathtree.h
+	@brief Shortest paths from one source to every vertex.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	The distance and parent of every vertex, as left by a complete Dijkstra's
+	search (see Graph::ShortestPathTree()). A path to any destination is a
+	walk up the parents, with no further searching. The tree is a snapshot:
+	it is out of date as soon as the Graph changes, and it points at the
+	Graph's vertices, so it must not outlive them.
+	*/
+	template<class T, Weighting W = RuntimeWeighting, class WeightType = int>
+	class PathTree
+	{
+		public:
+			/**
+			@param source The dense identifier of the source.
+			@param vertices The Graph's vertices by dense identifier (NULL for deleted ones).
+			@param searchState A finished search from the source.
+
+			Constructor
+			*/
+			PathTree(int source, const std::vector<Vertex<T, W, WeightType>*> &vertices, const SearchState &searchState);
+
+			/**
+			@return The dense identifier of the source.
+			*/
+			int Source(void) const;
+
+			/**
+			@param vertex A vertex of the Graph.
+			@return The distance from the source, or Infinity if it can't be reached.
+			*/
+			int Distance(const Vertex<T, W, WeightType> &vertex) const;
+
+			/**
+			@param vertex A vertex of the Graph.
+			@return The vertex before it on the shortest path, or NULL for the source and unreachable vertices.
+			*/
+			Vertex<T, W, WeightType> * Parent(const Vertex<T, W, WeightType> &vertex) const;
+
+			/**
+			@param vertex The destination vertex.
+			@return A queue that is the path to follow (empty if the destination can't be reached).
+			*/
+			std::queue<Vertex<T, W, WeightType>*> PathTo(const Vertex<T, W, WeightType> &vertex) const;
+
+		private:
+			int						source;		//!< The dense identifier of the source.
+			std::vector<int>		distances;	//!< Distances from the source by dense identifier.
+			std::vector<Vertex<T, W, WeightType>*>	parents;	//!< Parents by dense identifier.
+	};
+
+	template<class T, Weighting W, class WeightType>
+	PathTree<T, W, WeightType>::PathTree(int source, const std::vector<Vertex<T, W, WeightType>*> &vertices, const SearchState &searchState)
+	:source(source), distances(std::vector<int>(vertices.size())), parents(std::vector<Vertex<T, W, WeightType>*>(vertices.size()))
+	{
+		for (int i = 0; i < static_cast<int>(vertices.size()); i++)
+		{
+			distances[i] = searchState.Distance(i);
+			parents[i] = searchState.Parent(i) == -1 ? NULL : vertices[searchState.Parent(i)];
+		}
+	}
+
+	template<class T, Weighting W, class WeightType>
+	int PathTree<T, W, WeightType>::Source(void) const
+	{
+		return source;
+	}
+
+	template<class T, Weighting W, class WeightType>
+	int PathTree<T, W, WeightType>::Distance(const Vertex<T, W, WeightType> &vertex) const
+	{
+		/*
+		Vertices inserted after the search have no edges yet, so nothing reaches them.
+		*/
+		if (vertex.Index() < 0 || vertex.Index() >= static_cast<int>(distances.size()))
+			return Infinity;
+		return distances[vertex.Index()];
+	}
+
+	template<class T, Weighting W, class WeightType>
+	Vertex<T, W, WeightType> * PathTree<T, W, WeightType>::Parent(const Vertex<T, W, WeightType> &vertex) const
+	{
+		if (vertex.Index() < 0 || vertex.Index() >= static_cast<int>(parents.size()))
+			return NULL;
+		return parents[vertex.Index()];
+	}
+
+	template<class T, Weighting W, class WeightType>
+	std::queue<Vertex<T, W, WeightType>*> PathTree<T, W, WeightType>::PathTo(const Vertex<T, W, WeightType> &vertex) const
+	{
+		using namespace std;
+
+		list<Vertex<T, W, WeightType>*>		shortestPathList;	// The found shortest path.
+		queue<Vertex<T, W, WeightType>*>		shortestPath;		// The found shortest path (clean).
+
+		if (Distance(vertex) == Infinity)
+			return shortestPath;
+		for (Vertex<T, W, WeightType> *i = const_cast<Vertex<T, W, WeightType>*>(&vertex); i != NULL; i = parents[i->Index()])
+			shortestPathList.push_front(i);
+		for (typename list<Vertex<T, W, WeightType>*>::iterator i = shortestPathList.begin(); i != shortestPathList.end(); i++)
+			shortestPath.push(*i);
+		return shortestPath;
+	}
+}
+
+#endif
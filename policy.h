@@ -0,0 +1,166 @@
+//
+// C++ Interface: policy
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHPOLICY_H
+#define GRAPHPOLICY_H
+
+#include <boost/tuple/tuple.hpp>
+
+namespace Graphs
+{
+	/**
+	@brief Weighting enum for keywording the Graph.
+
+	This enum allows us to pass the keyword to the graph upon instantiation.
+	This sets up the graph in the desired way so that we have more control in
+	whether it is weighted. As a template argument it fixes the choice at
+	compile time; RuntimeWeighting (the default) leaves it to the constructor.
+	*/
+	enum Weighting
+	{
+		Weighted,						//!< Weighted Graph will be created.
+		Unweighted,						//!< Unweighted Graph will be created.
+		RuntimeWeighting				//!< Chosen when the Graph is constructed.
+	};
+
+	/**
+	@brief Direction enum for keywording the Graph.
+
+	This enum allows us to pass the keyword to the graph upon instantiation.
+	This sets up the graph in the desired way so that we have more control in
+	whether it is directed. As a template argument it fixes the choice at
+	compile time; RuntimeDirection (the default) leaves it to the constructor.
+	*/
+	enum Direction
+	{
+		Directed,						//!< Directed Graph will be created.
+		Undirected,						//!< Undirected Graph will be created.
+		RuntimeDirection				//!< Chosen when the Graph is constructed.
+	};
+
+	/**
+	Fun Things...
+
+	Only Graph, Vertex, PathTree and GraphListener take the policies. Everything built
+	on a Graph (FrozenGraph, ContractionHierarchy, DistanceMatrix,
+	DeltaStepping, BreadthFirst, the listeners that watch one, Loader,
+	GraphBuilder, Generator, KeyIndex, Snapshot and VersionedGraph) takes a
+	Graph<T>, which leaves both choices to the constructor; handing them a
+	Graph with either fixed at compile time doesn't compile. Such a Graph has
+	its own searches (ShortestPath(), BidirectionalShortestPath(),
+	AStarShortestPath(), ShortestPathTree() and ShortestPaths()) and nothing else.
+	*/
+	template<typename T, Weighting W = RuntimeWeighting, class WeightType = int> class Vertex;
+	template<class T, Direction D = RuntimeDirection, Weighting W = RuntimeWeighting, class WeightType = int> class Graph;
+
+	/**
+	@class EdgeStorage policy.h
+	@brief How a Vertex keeps each of its edges.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	An edge is a tuple of its end and its weight, stored as WeightType (an
+	integer type no wider than int). Graphs that are Unweighted at compile
+	time store the end alone and every edge weighs one.
+	*/
+	template<class End, Weighting W, class WeightType>
+	struct EdgeStorage
+	{
+		typedef boost::tuple<End*, WeightType>	Edge;	//!< The end of an edge and its weight.
+
+		/**
+		@param end The end of the edge.
+		@param weight The weight of the edge.
+		@return The edge.
+		*/
+		static Edge Make(End *end, int weight);
+
+		/**
+		@param edge The edge.
+		@return Its weight.
+		*/
+		static int Weight(const Edge &edge);
+
+		/**
+		@param edge The edge to change.
+		@param weight The new weight.
+		*/
+		static void SetWeight(Edge &edge, int weight);
+	};
+
+	/**
+	@class EdgeStorage policy.h
+	@brief How a Vertex of an Unweighted Graph keeps each of its edges: the end alone.
+	@author Alex Brandt <alunduil@alunduil.com>
+	*/
+	template<class End, class WeightType>
+	struct EdgeStorage<End, Unweighted, WeightType>
+	{
+		typedef boost::tuple<End*>	Edge;	//!< The end of an edge.
+
+		/**
+		@param end The end of the edge.
+		@param weight The weight of the edge (dropped).
+		@return The edge.
+		*/
+		static Edge Make(End *end, int weight);
+
+		/**
+		@param edge The edge.
+		@return One.
+		*/
+		static int Weight(const Edge &edge);
+
+		/**
+		@param edge The edge to change (it isn't).
+		@param weight The new weight (dropped).
+		*/
+		static void SetWeight(Edge &edge, int weight);
+	};
+
+	template<class End, Weighting W, class WeightType>
+	typename EdgeStorage<End, W, WeightType>::Edge EdgeStorage<End, W, WeightType>::Make(End *end, int weight)
+	{
+		return Edge(end, static_cast<WeightType>(weight));
+	}
+
+	template<class End, Weighting W, class WeightType>
+	int EdgeStorage<End, W, WeightType>::Weight(const Edge &edge)
+	{
+		return boost::get<1>(edge);
+	}
+
+	template<class End, Weighting W, class WeightType>
+	void EdgeStorage<End, W, WeightType>::SetWeight(Edge &edge, int weight)
+	{
+		boost::get<1>(edge) = static_cast<WeightType>(weight);
+		return;
+	}
+
+	template<class End, class WeightType>
+	typename EdgeStorage<End, Unweighted, WeightType>::Edge EdgeStorage<End, Unweighted, WeightType>::Make(End *end, int)
+	{
+		return Edge(end);
+	}
+
+	template<class End, class WeightType>
+	int EdgeStorage<End, Unweighted, WeightType>::Weight(const Edge &)
+	{
+		return 1;
+	}
+
+	template<class End, class WeightType>
+	void EdgeStorage<End, Unweighted, WeightType>::SetWeight(Edge &, int)
+	{
+		return;
+	}
+}
+
+#endif
@@ -0,0 +1,580 @@
+//
+// C++ Interface: searchstate
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHSEARCHSTATE_H
+#define GRAPHSEARCHSTATE_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+#include "vertex.h"
+
+namespace Graphs
+{
+	/**
+	@brief Are the searches counting their work?
+
+	Build with GRAPHS_INSTRUMENT defined to count (see SearchCounters and
+	GraphStats). Otherwise the counting is compiled out entirely.
+	*/
+#ifdef GRAPHS_INSTRUMENT
+	const bool	Instrumented = true;
+#else
+	const bool	Instrumented = false;
+#endif
+
+	/**
+	@brief The work one search did (all zero unless Instrumented).
+	*/
+	struct SearchCounters
+	{
+		unsigned long	settled;	//!< Vertices whose distance was made final.
+		unsigned long	relaxed;	//!< Edges looked along.
+		unsigned long	pushes;		//!< Entries pushed on the frontier.
+		unsigned long	pops;		//!< Entries popped off it (stale ones included).
+		unsigned long	decreases;	//!< Pushes that lowered a distance already on the frontier (the lazy decrease-key).
+
+		/**
+		Constructor
+		*/
+		SearchCounters(void);
+
+		/**
+		@param other More work to count in.
+		*/
+		void Add(const SearchCounters &other);
+	};
+
+	/**
+	@class SearchState searchstate.h
+	@brief Scratch space for the shortest path searches.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Distances, parents and the frontier heap live in flat vectors indexed by
+	the dense vertex identifiers. Every slot carries the generation that last
+	wrote it, so starting a new query is a counter bump rather than a sweep.
+	Breadth first searches use the frontier as a plain queue instead, through
+	Discover() and Next(); a query uses one or the other, not both.
+	*/
+	class SearchState
+	{
+		public:
+			/**
+			Constructor
+			*/
+			SearchState(void);
+
+			/**
+			@param size The number of vertex identifiers the next query may touch.
+
+			Start a new query, forgetting everything the last one learned.
+			*/
+			void Reset(int size);
+
+			/**
+			@param vertex The vertex identifier.
+			@return The tentative distance, or Infinity if the vertex hasn't been reached.
+			*/
+			int Distance(int vertex) const;
+
+			/**
+			@param vertex The vertex identifier.
+			@return The identifier of the parent vertex, or -1 for none.
+			*/
+			int Parent(int vertex) const;
+
+			/**
+			@param vertex The vertex identifier.
+			@return True if the vertex's distance is final.
+			*/
+			bool IsSettled(int vertex) const;
+
+			/**
+			@param vertex The vertex identifier.
+			@param candidate The candidate distance.
+			@param parent The vertex we came from.
+			@return True if the candidate was an improvement (and was pushed on the frontier).
+
+			Relax a vertex, the heart of the search.
+			*/
+			bool Improve(int vertex, int candidate, int parent);
+
+			/**
+			@param vertex The vertex identifier.
+			@param candidate The candidate distance.
+			@param parent The vertex we came from.
+			@param priority Where the vertex goes on the frontier (the candidate plus an estimate of the distance left).
+			@return True if the candidate was an improvement (and was pushed on the frontier).
+
+			Relax a vertex for a goal directed search. The frontier is ordered by priority
+			instead of distance, so a vertex's priority must not drop without its distance dropping.
+			*/
+			bool Improve(int vertex, int candidate, int parent, int priority);
+
+			/**
+			@param vertex The vertex identifier.
+			@param parent The vertex we came from (-1 for the source).
+			@return True if the vertex hadn't been reached before (and was queued).
+
+			Reach a vertex for a breadth first search, one hop further out than its parent.
+			*/
+			bool Discover(int vertex, int parent);
+
+			/**
+			@return The next vertex in the order they were discovered, or -1 once there are none.
+
+			Take a vertex off the front of the breadth first queue and settle it.
+			*/
+			int Next(void);
+
+			/**
+			@return True if there is nothing left on the frontier.
+			*/
+			bool IsFrontierEmpty(void) const;
+
+			/**
+			@return A lower bound on the priority of every unsettled vertex (Infinity if the frontier is empty).
+			*/
+			int FrontierMinimum(void) const;
+
+			/**
+			@return The closest unsettled vertex, or -1 once the frontier holds only stale entries.
+
+			Pop the frontier until an unsettled vertex turns up and settle it.
+			*/
+			int Settle(void);
+
+			/**
+			@return The work done since the last Reset() (all zero unless Instrumented).
+			*/
+			const SearchCounters &Counters(void) const;
+
+			/**
+			Count an edge looked along that the caller decided not to hand to Improve().
+			*/
+			void CountRelaxation(void);
+
+		private:
+			typedef std::pair<int, int>	HeapEntry;	//!< Priority (usually the tentative distance) and the vertex identifier it belongs to.
+
+			std::vector<int>			distance;		//!< Tentative distances.
+			std::vector<int>			parents;		//!< The parent lookup list.
+			std::vector<unsigned int>	reached;		//!< Generation that last wrote distance and parent.
+			std::vector<unsigned int>	settled;		//!< Generation that last settled the vertex.
+			std::vector<HeapEntry>		frontier;		//!< Min-heap of reached vertices (lazy deletion).
+			std::size_t					head;			//!< The front of the breadth first queue.
+			unsigned int				generation;		//!< The current query.
+			SearchCounters				counters;		//!< The work done by the current query.
+	};
+
+	/**
+	@class Relaxation searchstate.h
+	@brief Edge visitor that relaxes the edges leaving a settled vertex.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Hand one to Vertex::ForEachEdge() so the weight arrives with the neighbor.
+	*/
+	template<class T, Weighting W = RuntimeWeighting, class WeightType = int>
+	class Relaxation
+	{
+		public:
+			/**
+			@param searchState The search being run.
+			@param vertex The identifier of the settled vertex whose edges are visited.
+
+			Constructor
+			*/
+			Relaxation(SearchState &searchState, int vertex);
+
+			/**
+			@param end The end of the edge.
+			@param weight The weight of the edge.
+			*/
+			void operator()(const Vertex<T, W, WeightType> *end, int weight);
+
+		private:
+			SearchState		&searchState;	//!< The search being run.
+			const int		vertex;			//!< The settled vertex.
+			const int		distance;		//!< The settled vertex's distance.
+	};
+
+	/**
+	@class Discovery searchstate.h
+	@brief Edge visitor that discovers the neighbors of a vertex, breadth first.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	The weight is ignored: every edge is one hop.
+	*/
+	template<class T, Weighting W = RuntimeWeighting, class WeightType = int>
+	class Discovery
+	{
+		public:
+			/**
+			@param searchState The search being run.
+			@param vertex The identifier of the vertex whose edges are visited.
+
+			Constructor
+			*/
+			Discovery(SearchState &searchState, int vertex);
+
+			/**
+			@param end The end of the edge.
+			@param weight The weight of the edge (unused).
+			*/
+			void operator()(const Vertex<T, W, WeightType> *end, int weight);
+
+		private:
+			SearchState		&searchState;	//!< The search being run.
+			const int		vertex;			//!< The vertex whose edges are visited.
+	};
+
+	/**
+	@class GuidedRelaxation searchstate.h
+	@brief Edge visitor that relaxes the edges leaving a settled vertex, A* style.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Like Relaxation, but each improved vertex goes on the frontier at its
+	distance plus heuristic(*vertex, target), the estimate of what's left.
+	The heuristic is only asked about vertices that actually improve. In an
+	Unweighted Graph every edge counts as one, whatever weight it holds.
+	*/
+	template<class T, class Heuristic, Weighting W = RuntimeWeighting, class WeightType = int>
+	class GuidedRelaxation
+	{
+		public:
+			/**
+			@param searchState The search being run.
+			@param vertex The identifier of the settled vertex whose edges are visited.
+			@param target Where the search is going.
+			@param heuristic The estimate of the distance left.
+			@param weighted Do the edge weights count (or is every edge one)?
+
+			Constructor
+			*/
+			GuidedRelaxation(SearchState &searchState, int vertex, const Vertex<T, W, WeightType> &target, Heuristic &heuristic, bool weighted);
+
+			/**
+			@param end The end of the edge.
+			@param weight The weight of the edge.
+			*/
+			void operator()(const Vertex<T, W, WeightType> *end, int weight);
+
+		private:
+			SearchState		&searchState;	//!< The search being run.
+			const int		vertex;			//!< The settled vertex.
+			const int		distance;		//!< The settled vertex's distance.
+			const Vertex<T, W, WeightType>	&target;		//!< Where the search is going.
+			Heuristic		&heuristic;		//!< The estimate of the distance left.
+			const bool		weighted;		//!< Do the edge weights count?
+	};
+
+	/**
+	@param searchState The scratch space to search in (Reset() for size vertices first).
+	@param offsets Where each vertex's edges start; size + 1 entries.
+	@param targets The end of each edge.
+	@param weights The weight of each edge.
+	@param source Where we start.
+	@param target Where we're going.
+	@return True if the target was reached; the path is in searchState's parents.
+
+	Dijkstra's shortest path over compressed sparse rows, ending when the target is settled.
+	*/
+	template<class Index>
+	bool SearchRows(SearchState &searchState, const Index *offsets, const Index *targets, const Index *weights, int source, int target);
+
+	/**
+	@param forward The scratch space for the search out of the source (Reset() first).
+	@param backward The scratch space for the search into the target (Reset() first).
+	@param offsets Where each vertex's edges start; one entry past the last vertex.
+	@param targets The end of each edge.
+	@param weights The weight of each edge.
+	@param reverseOffsets Where each vertex's incoming edges start in the reverse rows.
+	@param sources The start of each incoming edge.
+	@param reverseWeights The weight of each incoming edge.
+	@param source Where we start.
+	@param target Where we're going.
+	@return The vertex where the two searches met on a shortest path, or -1 if the target can't be reached.
+
+	Bidirectional Dijkstra over compressed sparse rows. The path runs along forward's parents from the
+	meeting vertex back to the source, and along backward's parents from it on to the target.
+	*/
+	template<class Index>
+	int SearchRowsBidirectional(SearchState &forward, SearchState &backward, const Index *offsets, const Index *targets, const Index *weights, const Index *reverseOffsets, const Index *sources, const Index *reverseWeights, int source, int target);
+
+	inline SearchCounters::SearchCounters(void)
+	:settled(0), relaxed(0), pushes(0), pops(0), decreases(0)
+	{
+	}
+
+	inline void SearchCounters::Add(const SearchCounters &other)
+	{
+		settled += other.settled;
+		relaxed += other.relaxed;
+		pushes += other.pushes;
+		pops += other.pops;
+		decreases += other.decreases;
+		return;
+	}
+
+	inline SearchState::SearchState(void)
+	:distance(std::vector<int>()), parents(std::vector<int>()), reached(std::vector<unsigned int>()), settled(std::vector<unsigned int>()), frontier(std::vector<HeapEntry>()), head(0), generation(0), counters(SearchCounters())
+	{
+	}
+
+	inline void SearchState::Reset(int size)
+	{
+		if (static_cast<int>(distance.size()) < size)
+		{
+			distance.resize(size);
+			parents.resize(size);
+			reached.resize(size, 0);
+			settled.resize(size, 0);
+		}
+		frontier.clear();
+		head = 0;
+		if (Instrumented)
+			counters = SearchCounters();
+
+		/*
+		Stamps are only ever compared for equality, so a wrapped counter must
+		not meet a stamp left over from four billion queries ago.
+		*/
+		if (++generation == 0)
+		{
+			std::fill(reached.begin(), reached.end(), 0);
+			std::fill(settled.begin(), settled.end(), 0);
+			generation = 1;
+		}
+		return;
+	}
+
+	inline int SearchState::Distance(int vertex) const
+	{
+		return reached[vertex] == generation ? distance[vertex] : Infinity;
+	}
+
+	inline int SearchState::Parent(int vertex) const
+	{
+		return reached[vertex] == generation ? parents[vertex] : -1;
+	}
+
+	inline bool SearchState::IsSettled(int vertex) const
+	{
+		return settled[vertex] == generation;
+	}
+
+	inline bool SearchState::Improve(int vertex, int candidate, int parent)
+	{
+		return Improve(vertex, candidate, parent, candidate);
+	}
+
+	inline bool SearchState::Improve(int vertex, int candidate, int parent, int priority)
+	{
+		if (Instrumented && parent != -1)
+			counters.relaxed++;
+		if (IsSettled(vertex) || candidate >= Distance(vertex))
+			return false;
+		if (Instrumented)
+		{
+			counters.pushes++;
+			if (reached[vertex] == generation)
+				counters.decreases++;
+		}
+		reached[vertex] = generation;
+		distance[vertex] = candidate;
+		parents[vertex] = parent;
+		frontier.push_back(HeapEntry(priority, vertex));
+		std::push_heap(frontier.begin(), frontier.end(), std::greater<HeapEntry>());
+		return true;
+	}
+
+	inline bool SearchState::Discover(int vertex, int parent)
+	{
+		if (Instrumented && parent != -1)
+			counters.relaxed++;
+		if (reached[vertex] == generation)
+			return false;
+		if (Instrumented)
+			counters.pushes++;
+		reached[vertex] = generation;
+		distance[vertex] = parent == -1 ? 0 : distance[parent] + 1;
+		parents[vertex] = parent;
+		frontier.push_back(HeapEntry(distance[vertex], vertex));
+		return true;
+	}
+
+	inline int SearchState::Next(void)
+	{
+		if (head == frontier.size())
+			return -1;
+		if (Instrumented)
+		{
+			counters.pops++;
+			counters.settled++;
+		}
+		settled[frontier[head].second] = generation;
+		return frontier[head++].second;
+	}
+
+	inline bool SearchState::IsFrontierEmpty(void) const
+	{
+		return frontier.size() == head;
+	}
+
+	inline int SearchState::FrontierMinimum(void) const
+	{
+		return frontier.empty() ? Infinity : frontier.front().first;
+	}
+
+	inline int SearchState::Settle(void)
+	{
+		while (!frontier.empty())
+		{
+			int	vertex = frontier.front().second;	// Closest entry on the frontier.
+
+			std::pop_heap(frontier.begin(), frontier.end(), std::greater<HeapEntry>());
+			frontier.pop_back();
+			if (Instrumented)
+				counters.pops++;
+			if (!IsSettled(vertex))
+			{
+				if (Instrumented)
+					counters.settled++;
+				settled[vertex] = generation;
+				return vertex;
+			}
+		}
+		return -1;
+	}
+
+	inline const SearchCounters &SearchState::Counters(void) const
+	{
+		return counters;
+	}
+
+	inline void SearchState::CountRelaxation(void)
+	{
+		if (Instrumented)
+			counters.relaxed++;
+		return;
+	}
+
+	template<class Index>
+	bool SearchRows(SearchState &searchState, const Index *offsets, const Index *targets, const Index *weights, int source, int target)
+	{
+		searchState.Improve(source, 0, -1);
+		for (int current = searchState.Settle(); current != -1 && current != target; current = searchState.Settle())
+		{
+			const int	currentDistance = searchState.Distance(current),
+						end = offsets[current + 1];
+
+			for (int edge = offsets[current]; edge < end; edge++)
+				searchState.Improve(targets[edge], currentDistance + weights[edge], current);
+		}
+		return searchState.IsSettled(target);
+	}
+
+	template<class Index>
+	int SearchRowsBidirectional(SearchState &forward, SearchState &backward, const Index *offsets, const Index *targets, const Index *weights, const Index *reverseOffsets, const Index *sources, const Index *reverseWeights, int source, int target)
+	{
+		int	best = Infinity,	// Length of the shortest path seen so far.
+			meeting = -1;		// Where that path crosses from one search to the other.
+
+		forward.Improve(source, 0, -1);
+		backward.Improve(target, 0, -1);
+		if (source == target)
+			return source;
+
+		/*
+		Grow whichever search has the nearer frontier. Once the two frontiers
+		together are no nearer than the best path, no unsettled vertex can
+		lie on a shorter one.
+		*/
+		while (!forward.IsFrontierEmpty() && !backward.IsFrontierEmpty()
+			&& static_cast<long long>(forward.FrontierMinimum()) + backward.FrontierMinimum() < best)
+		{
+			const bool	outward = forward.FrontierMinimum() <= backward.FrontierMinimum();	// Growing the forward search?
+			SearchState	&near = outward ? forward : backward,		// The search being grown.
+						&far = outward ? backward : forward;		// The other one.
+			const Index	*rows = outward ? offsets : reverseOffsets,
+						*ends = outward ? targets : sources,
+						*costs = outward ? weights : reverseWeights;
+			const int	current = near.Settle();					// The vertex being settled.
+
+			if (current == -1)
+				break;
+
+			const int	currentDistance = near.Distance(current),
+						end = rows[current + 1];
+
+			for (int edge = rows[current]; edge < end; edge++)
+			{
+				const int	next = ends[edge];	// The far end of the edge.
+
+				near.Improve(next, currentDistance + costs[edge], current);
+				if (far.Distance(next) != Infinity && static_cast<long long>(near.Distance(next)) + far.Distance(next) < best)
+				{
+					best = near.Distance(next) + far.Distance(next);
+					meeting = next;
+				}
+			}
+		}
+		return meeting;
+	}
+
+	template<class T, Weighting W, class WeightType>
+	Relaxation<T, W, WeightType>::Relaxation(SearchState &searchState, int vertex)
+	:searchState(searchState), vertex(vertex), distance(searchState.Distance(vertex))
+	{
+	}
+
+	template<class T, Weighting W, class WeightType>
+	void Relaxation<T, W, WeightType>::operator()(const Vertex<T, W, WeightType> *end, int weight)
+	{
+		searchState.Improve(end->Index(), distance + weight, vertex);
+		return;
+	}
+
+	template<class T, Weighting W, class WeightType>
+	Discovery<T, W, WeightType>::Discovery(SearchState &searchState, int vertex)
+	:searchState(searchState), vertex(vertex)
+	{
+	}
+
+	template<class T, Weighting W, class WeightType>
+	void Discovery<T, W, WeightType>::operator()(const Vertex<T, W, WeightType> *end, int)
+	{
+		searchState.Discover(end->Index(), vertex);
+		return;
+	}
+
+	template<class T, class Heuristic, Weighting W, class WeightType>
+	GuidedRelaxation<T, Heuristic, W, WeightType>::GuidedRelaxation(SearchState &searchState, int vertex, const Vertex<T, W, WeightType> &target, Heuristic &heuristic, bool weighted)
+	:searchState(searchState), vertex(vertex), distance(searchState.Distance(vertex)), target(target), heuristic(heuristic), weighted(weighted)
+	{
+	}
+
+	template<class T, class Heuristic, Weighting W, class WeightType>
+	void GuidedRelaxation<T, Heuristic, W, WeightType>::operator()(const Vertex<T, W, WeightType> *end, int weight)
+	{
+		const int	candidate = distance + (weighted ? weight : 1);	// The distance to end through the settled vertex.
+
+		if (!searchState.IsSettled(end->Index()) && candidate < searchState.Distance(end->Index()))
+			searchState.Improve(end->Index(), candidate, vertex, candidate + heuristic(*end, target));
+		else
+			searchState.CountRelaxation();
+		return;
+	}
+}
+
+#endif
@@ -0,0 +1,212 @@
+//
+// C++ Interface: shortestpathcache
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHSHORTESTPATHCACHE_H
+#define GRAPHSHORTESTPATHCACHE_H
+
+#include <list>
+#include <queue>
+#include <utility>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "graph.h"
+#include "graphlistener.h"
+#include "pathtree.h"
+
+namespace Graphs
+{
+	/**
+	@class ShortestPathCache shortestpathcache.h
+	@brief The shortest path trees of the most recently used sources.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	When a few sources account for most queries, keeping their trees turns a
+	repeat query into a walk up the parents. The cache holds up to a fixed
+	number of trees and drops the least recently used one to make room. It
+	listens to the Graph and throws every tree away when an edge is inserted
+	or deleted, a weight changes, or a vertex is deleted; inserting a vertex
+	leaves the trees alone since nothing reaches it yet.
+
+	Trees handed out stay valid for their holders after they're dropped from
+	the cache, but like any PathTree they're out of date once the Graph changes.
+	*/
+	template<class T>
+	class ShortestPathCache : public GraphListener<T>
+	{
+		public:
+			typedef boost::shared_ptr<const PathTree<T> >	TreePointer;	//!< A tree shared with the cache.
+
+			/**
+			@param graph The Graph to answer queries on.
+			@param capacity The most trees to keep.
+
+			Constructor
+			*/
+			explicit ShortestPathCache(Graph<T> &graph, int capacity = 16);
+
+			/**
+			Destructor
+			*/
+			~ShortestPathCache(void);
+
+			/**
+			@param source The source vertex.
+			@return The shortest path tree from the source, searched for only if it isn't cached.
+			*/
+			TreePointer Tree(const Vertex<T> &source);
+
+			/**
+			@param vertexA The source vertex.
+			@param vertexB The destination vertex.
+			@return A queue that is the path to follow.
+			*/
+			std::queue<Vertex<T>*> ShortestPath(const Vertex<T> &vertexA, const Vertex<T> &vertexB);
+
+			/**
+			@return The number of trees cached.
+			*/
+			int Size(void) const;
+
+			/**
+			Drop every tree.
+			*/
+			void Clear(void);
+
+			/**
+			@param vertex The vertex about to be deleted.
+			*/
+			void VertexDeleted(const Vertex<T> &vertex);
+
+			/**
+			@param from Where the new edge starts.
+			@param to Where the new edge ends.
+			@param weight The weight of the new edge.
+			*/
+			void EdgeInserted(Vertex<T> &from, Vertex<T> &to, int weight);
+
+			/**
+			@param from Where the deleted edges started.
+			@param to Where the deleted edges ended.
+			*/
+			void EdgeDeleted(Vertex<T> &from, Vertex<T> &to);
+
+			/**
+			@param from Where the edge starts.
+			@param to Where the edge ends.
+			@param oldWeight The weight it had.
+			@param newWeight The weight it has now.
+			*/
+			void WeightChanged(Vertex<T> &from, Vertex<T> &to, int oldWeight, int newWeight);
+
+		private:
+			typedef std::list<std::pair<int, TreePointer> >	Entries;	//!< Sources and their trees, most recently used first.
+
+			Graph<T>											&graph;		//!< The Graph being searched.
+			int													capacity;	//!< The most trees to keep.
+			Entries												entries;	//!< The trees, most recently used first.
+			boost::unordered_map<int, typename Entries::iterator>	lookup;		//!< Where each source's tree is in entries.
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			ShortestPathCache(const ShortestPathCache &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			ShortestPathCache &operator=(const ShortestPathCache &);
+	};
+
+	template<class T>
+	ShortestPathCache<T>::ShortestPathCache(Graph<T> &graph, int capacity)
+	:GraphListener<T>(), graph(graph), capacity(capacity > 0 ? capacity : 1), entries(Entries()), lookup(boost::unordered_map<int, typename Entries::iterator>())
+	{
+		graph.Attach(*this);
+	}
+
+	template<class T>
+	ShortestPathCache<T>::~ShortestPathCache(void)
+	{
+		graph.Detach(*this);
+	}
+
+	template<class T>
+	typename ShortestPathCache<T>::TreePointer ShortestPathCache<T>::Tree(const Vertex<T> &source)
+	{
+		typename boost::unordered_map<int, typename Entries::iterator>::iterator found = lookup.find(source.Index());
+
+		if (found != lookup.end())
+		{
+			entries.splice(entries.begin(), entries, found->second);
+			return entries.front().second;
+		}
+
+		if (static_cast<int>(entries.size()) == capacity)
+		{
+			lookup.erase(entries.back().first);
+			entries.pop_back();
+		}
+		entries.push_front(std::make_pair(source.Index(), TreePointer(new PathTree<T>(graph.ShortestPathTree(source)))));
+		lookup[source.Index()] = entries.begin();
+		return entries.front().second;
+	}
+
+	template<class T>
+	std::queue<Vertex<T>*> ShortestPathCache<T>::ShortestPath(const Vertex<T> &vertexA, const Vertex<T> &vertexB)
+	{
+		return Tree(vertexA)->PathTo(vertexB);
+	}
+
+	template<class T>
+	int ShortestPathCache<T>::Size(void) const
+	{
+		return entries.size();
+	}
+
+	template<class T>
+	void ShortestPathCache<T>::Clear(void)
+	{
+		entries.clear();
+		lookup.clear();
+		return;
+	}
+
+	template<class T>
+	void ShortestPathCache<T>::VertexDeleted(const Vertex<T> &)
+	{
+		Clear();
+		return;
+	}
+
+	template<class T>
+	void ShortestPathCache<T>::EdgeInserted(Vertex<T> &, Vertex<T> &, int)
+	{
+		Clear();
+		return;
+	}
+
+	template<class T>
+	void ShortestPathCache<T>::EdgeDeleted(Vertex<T> &, Vertex<T> &)
+	{
+		Clear();
+		return;
+	}
+
+	template<class T>
+	void ShortestPathCache<T>::WeightChanged(Vertex<T> &, Vertex<T> &, int, int)
+	{
+		Clear();
+		return;
+	}
+}
+
+#endif
@@ -0,0 +1,504 @@
+//
+// C++ Interface: snapshot
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHSNAPSHOT_H
+#define GRAPHSNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <queue>
+#include <list>
+#include <fstream>
+#include <cstring>
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_pod.hpp>
+
+#include "graph.h"
+#include "mappedfile.h"
+#include "searchstate.h"
+
+namespace Graphs
+{
+	/**
+	@brief Fixed header at the start of every snapshot file.
+
+	All fields are in the byte order of the machine that wrote the file; the
+	byteOrder field lets a reader on another machine tell. Sections start at
+	the given byte offsets, each aligned to 8 bytes:
+		- present: one byte per vertex identifier, 0 for deleted identifiers.
+		- offsets: int32 per identifier plus one; edges of v are offsets[v] to offsets[v + 1].
+		- targets: int32 per edge, the identifier of its end.
+		- weights: int32 per edge (1 for every edge of an Unweighted Graph).
+		- payloadOffsets: uint64 per identifier plus one, into the payload section.
+		- payload: the vertex data, as written by SnapshotPayload<T>.
+	*/
+	struct SnapshotHeader
+	{
+		char			magic[8];				//!< "GRAPHSNP"
+		boost::uint32_t	version;				//!< SnapshotHeader::Version when written.
+		boost::uint32_t	byteOrder;				//!< 0x01020304 as the writer stored it.
+		boost::uint64_t	vertexCount;			//!< Number of vertex identifiers (including deleted ones).
+		boost::uint64_t	edgeCount;				//!< Number of adjacency entries.
+		boost::uint64_t	presentOffset;			//!< Where the present section starts.
+		boost::uint64_t	offsetsOffset;			//!< Where the offsets section starts.
+		boost::uint64_t	targetsOffset;			//!< Where the targets section starts.
+		boost::uint64_t	weightsOffset;			//!< Where the weights section starts.
+		boost::uint64_t	payloadOffsetsOffset;	//!< Where the payload offsets section starts.
+		boost::uint64_t	payloadOffset;			//!< Where the payload section starts.
+		boost::uint64_t	payloadSize;			//!< The size of the payload section.
+
+		static const boost::uint32_t	Version = 1;			//!< The format this code reads and writes.
+		static const boost::uint32_t	ByteOrder = 0x01020304;	//!< Byte order mark.
+	};
+
+	/**
+	@brief How vertex data is stored in a snapshot.
+
+	The general case copies the bytes of T, which is only right for plain old
+	data. Specialise it for anything else.
+	*/
+	template<class T>
+	struct SnapshotPayload
+	{
+		BOOST_STATIC_ASSERT(boost::is_pod<T>::value);
+
+		/**
+		@param data The vertex data.
+		@return The bytes needed to store it.
+		*/
+		static std::size_t Size(const T &data)
+		{
+			return sizeof(data);
+		}
+
+		/**
+		@param out Where to store it (Size() bytes).
+		@param data The vertex data.
+		*/
+		static void Write(char *out, const T &data)
+		{
+			std::memcpy(out, &data, sizeof(data));
+		}
+
+		/**
+		@param in The stored bytes.
+		@param size How many there are.
+		@return The vertex data.
+		*/
+		static T Read(const char *in, std::size_t size)
+		{
+			T	data;	// The vertex data.
+
+			std::memcpy(&data, in, size < sizeof(data) ? size : sizeof(data));
+			return data;
+		}
+	};
+
+	/**
+	@brief Strings are stored as their characters.
+	*/
+	template<>
+	struct SnapshotPayload<std::string>
+	{
+		/**
+		@param data The vertex data.
+		@return The bytes needed to store it.
+		*/
+		static std::size_t Size(const std::string &data)
+		{
+			return data.size();
+		}
+
+		/**
+		@param out Where to store it (Size() bytes).
+		@param data The vertex data.
+		*/
+		static void Write(char *out, const std::string &data)
+		{
+			data.copy(out, data.size());
+		}
+
+		/**
+		@param in The stored bytes.
+		@param size How many there are.
+		@return The vertex data.
+		*/
+		static std::string Read(const char *in, std::size_t size)
+		{
+			return std::string(in, size);
+		}
+	};
+
+	/**
+	@class Snapshot snapshot.h
+	@brief A Graph saved in a binary file that is queried where it lies.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Write() lays a Graph out as compressed sparse rows plus the vertex data.
+	Open() maps such a file and checks its header; nothing is read or built
+	beyond that, so opening is immediate whatever the size of the graph, and
+	processes with the same file open share its pages. Vertices are named by
+	the dense identifiers they had in the Graph.
+	*/
+	template<class T>
+	class Snapshot
+	{
+		public:
+			/**
+			Constructor
+			*/
+			Snapshot(void);
+
+			/**
+			@param graph The Graph to save.
+			@param path Where to save it.
+			@return True if the file was written.
+			*/
+			static bool Write(const Graph<T> &graph, const std::string &path);
+
+			/**
+			@param path The snapshot file.
+			@return True if the file is mapped and looks like a snapshot; otherwise false (see Error()).
+			*/
+			bool Open(const std::string &path);
+
+			/**
+			@return What went wrong with the last Open().
+			*/
+			const std::string &Error(void) const;
+
+			/**
+			@return One past the largest vertex identifier.
+			*/
+			int IndexCount(void) const;
+
+			/**
+			@return The number of adjacency entries.
+			*/
+			int EdgeCount(void) const;
+
+			/**
+			@param vertex The vertex identifier.
+			@return True unless the vertex had been deleted from the Graph.
+			*/
+			bool IsPresent(int vertex) const;
+
+			/**
+			@param vertex The vertex identifier.
+			@return The offset of the vertex's first edge.
+
+			The edges of vertex run from EdgesBegin(vertex) up to EdgesBegin(vertex + 1).
+			*/
+			int EdgesBegin(int vertex) const;
+
+			/**
+			@param edge The offset of the edge.
+			@return The identifier of the vertex the edge goes to.
+			*/
+			int Target(int edge) const;
+
+			/**
+			@param edge The offset of the edge.
+			@return The weight of the edge.
+			*/
+			int Weight(int edge) const;
+
+			/**
+			@param vertex The vertex identifier.
+			@return The vertex's data.
+			*/
+			T Get(int vertex) const;
+
+			/**
+			@param source The identifier of the source vertex.
+			@param target The identifier of the destination vertex.
+			@return A queue of identifiers that is the path to follow.
+
+			Dijkstra's shortest path from one node to another, straight off the mapped file.
+			*/
+			std::queue<int> ShortestPath(int source, int target);
+
+		private:
+			MappedFile				file;			//!< The mapped snapshot.
+			const SnapshotHeader	*header;		//!< The header at the start of the file.
+			const char				*present;		//!< Present flags by identifier.
+			const boost::int32_t	*offsets;		//!< Where each vertex's edges start.
+			const boost::int32_t	*targets;		//!< The end of each edge.
+			const boost::int32_t	*weights;		//!< The weight of each edge.
+			const boost::uint64_t	*payloadOffsets;	//!< Where each vertex's data starts in payload.
+			const char				*payload;		//!< The vertex data.
+			SearchState				searchState;	//!< Scratch space reused by every ShortestPath().
+			std::string				error;			//!< What went wrong with the last Open().
+
+			/**
+			@param message What's wrong.
+			@return False, so the error can be returned directly.
+			*/
+			bool Fail(const std::string &message);
+
+			/**
+			@param offset Where a section starts.
+			@param size How long it is.
+			@return True if the section lies inside the file and is aligned.
+			*/
+			bool Contains(boost::uint64_t offset, boost::uint64_t size) const;
+
+			/**
+			@param out The file being written.
+			@param data The bytes to write.
+			@param size How many there are.
+			*/
+			static void WriteSection(std::ofstream &out, const void *data, std::size_t size);
+
+			/**
+			@param size A section size.
+			@return The size padded to 8 bytes.
+			*/
+			static boost::uint64_t Align(boost::uint64_t size);
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			Snapshot(const Snapshot &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			Snapshot &operator=(const Snapshot &);
+	};
+
+	template<class T>
+	Snapshot<T>::Snapshot(void)
+	:file(), header(NULL), present(NULL), offsets(NULL), targets(NULL), weights(NULL), payloadOffsets(NULL), payload(NULL), searchState(SearchState()), error(std::string())
+	{
+	}
+
+	template<class T>
+	boost::uint64_t Snapshot<T>::Align(boost::uint64_t size)
+	{
+		return (size + 7) / 8 * 8;
+	}
+
+	template<class T>
+	void Snapshot<T>::WriteSection(std::ofstream &out, const void *data, std::size_t size)
+	{
+		static const char	padding[8] = { 0 };	// Zeroes to align the next section.
+
+		out.write(static_cast<const char*>(data), size);
+		out.write(padding, Align(size) - size);
+		return;
+	}
+
+	template<class T>
+	bool Snapshot<T>::Write(const Graph<T> &graph, const std::string &path)
+	{
+		using namespace std;
+
+		const int					count = graph.IndexCount();	// Vertex identifiers to write.
+		SnapshotHeader				fileHeader;						// The fileHeader to write.
+		vector<char>				presentSection(count, 0);
+		vector<boost::int32_t>		offsetsSection(count + 1, 0),
+									targetsSection,
+									weightsSection;
+		vector<boost::uint64_t>		payloadOffsetsSection(count + 1, 0);
+		vector<char>				payloadSection;
+		ofstream					out(path.c_str(), ios::out | ios::binary | ios::trunc);
+
+		if (!out)
+			return false;
+
+		/*
+		Lay the Graph out in memory exactly as it goes in the file.
+		*/
+		for (int i = 0; i < count; i++)
+		{
+			const Vertex<T>	*vertex = graph.VertexAt(i);	// NULL for deleted identifiers.
+
+			offsetsSection[i + 1] = offsetsSection[i];
+			payloadOffsetsSection[i + 1] = payloadOffsetsSection[i];
+			if (vertex == NULL)
+				continue;
+
+			presentSection[i] = 1;
+			offsetsSection[i + 1] += vertex->Degree();
+			payloadOffsetsSection[i + 1] += SnapshotPayload<T>::Size(vertex->Get());
+		}
+		targetsSection.reserve(offsetsSection[count]);
+		weightsSection.reserve(offsetsSection[count]);
+		payloadSection.resize(payloadOffsetsSection[count]);
+		for (int i = 0; i < count; i++)
+		{
+			const Vertex<T>	*vertex = graph.VertexAt(i);	// NULL for deleted identifiers.
+
+			if (vertex == NULL)
+				continue;
+			for (typename Vertex<T>::EdgeIterator j = vertex->EdgesBegin(); j != vertex->EdgesEnd(); j++)
+			{
+				targetsSection.push_back(boost::get<0>(*j)->Index());
+				weightsSection.push_back(graph.IsWeighted() ? boost::get<1>(*j) : 1);
+			}
+			if (payloadOffsetsSection[i + 1] != payloadOffsetsSection[i])
+				SnapshotPayload<T>::Write(&payloadSection[payloadOffsetsSection[i]], vertex->Get());
+		}
+
+		memset(&fileHeader, 0, sizeof(fileHeader));
+		memcpy(fileHeader.magic, "GRAPHSNP", sizeof(fileHeader.magic));
+		fileHeader.version = SnapshotHeader::Version;
+		fileHeader.byteOrder = SnapshotHeader::ByteOrder;
+		fileHeader.vertexCount = count;
+		fileHeader.edgeCount = offsetsSection[count];
+		fileHeader.presentOffset = Align(sizeof(fileHeader));
+		fileHeader.offsetsOffset = fileHeader.presentOffset + Align(presentSection.size());
+		fileHeader.targetsOffset = fileHeader.offsetsOffset + Align(offsetsSection.size() * sizeof(boost::int32_t));
+		fileHeader.weightsOffset = fileHeader.targetsOffset + Align(targetsSection.size() * sizeof(boost::int32_t));
+		fileHeader.payloadOffsetsOffset = fileHeader.weightsOffset + Align(weightsSection.size() * sizeof(boost::int32_t));
+		fileHeader.payloadOffset = fileHeader.payloadOffsetsOffset + Align(payloadOffsetsSection.size() * sizeof(boost::uint64_t));
+		fileHeader.payloadSize = payloadSection.size();
+
+		WriteSection(out, &fileHeader, sizeof(fileHeader));
+		WriteSection(out, presentSection.empty() ? NULL : &presentSection[0], presentSection.size());
+		WriteSection(out, &offsetsSection[0], offsetsSection.size() * sizeof(boost::int32_t));
+		WriteSection(out, targetsSection.empty() ? NULL : &targetsSection[0], targetsSection.size() * sizeof(boost::int32_t));
+		WriteSection(out, weightsSection.empty() ? NULL : &weightsSection[0], weightsSection.size() * sizeof(boost::int32_t));
+		WriteSection(out, &payloadOffsetsSection[0], payloadOffsetsSection.size() * sizeof(boost::uint64_t));
+		WriteSection(out, payloadSection.empty() ? NULL : &payloadSection[0], payloadSection.size());
+		out.close();
+		return !out.fail();
+	}
+
+	template<class T>
+	bool Snapshot<T>::Open(const std::string &path)
+	{
+		error.clear();
+		header = NULL;
+		if (!file.Open(path, false))
+			return Fail("can't open " + path);
+		if (file.Size() < sizeof(SnapshotHeader))
+			return Fail(path + " is too short to be a snapshot");
+
+		header = reinterpret_cast<const SnapshotHeader*>(file.Begin());
+		if (std::memcmp(header->magic, "GRAPHSNP", sizeof(header->magic)) != 0)
+			return Fail(path + " is not a snapshot");
+		if (header->byteOrder != SnapshotHeader::ByteOrder)
+			return Fail(path + " was written on a machine with another byte order");
+		if (header->version != SnapshotHeader::Version)
+			return Fail(path + " is a snapshot in an unknown version");
+		if (header->vertexCount >= static_cast<boost::uint64_t>(Infinity) || header->edgeCount >= static_cast<boost::uint64_t>(Infinity))
+			return Fail(path + " is too large");
+
+		/*
+		Only the layout is checked; the rows themselves are trusted.
+		*/
+		if (!Contains(header->presentOffset, header->vertexCount)
+			|| !Contains(header->offsetsOffset, (header->vertexCount + 1) * sizeof(boost::int32_t))
+			|| !Contains(header->targetsOffset, header->edgeCount * sizeof(boost::int32_t))
+			|| !Contains(header->weightsOffset, header->edgeCount * sizeof(boost::int32_t))
+			|| !Contains(header->payloadOffsetsOffset, (header->vertexCount + 1) * sizeof(boost::uint64_t))
+			|| !Contains(header->payloadOffset, header->payloadSize))
+			return Fail(path + " is truncated or corrupt");
+
+		present = file.Begin() + header->presentOffset;
+		offsets = reinterpret_cast<const boost::int32_t*>(file.Begin() + header->offsetsOffset);
+		targets = reinterpret_cast<const boost::int32_t*>(file.Begin() + header->targetsOffset);
+		weights = reinterpret_cast<const boost::int32_t*>(file.Begin() + header->weightsOffset);
+		payloadOffsets = reinterpret_cast<const boost::uint64_t*>(file.Begin() + header->payloadOffsetsOffset);
+		payload = file.Begin() + header->payloadOffset;
+		if (offsets[header->vertexCount] != static_cast<boost::int32_t>(header->edgeCount) || payloadOffsets[header->vertexCount] != header->payloadSize)
+			return Fail(path + " is truncated or corrupt");
+		return true;
+	}
+
+	template<class T>
+	const std::string &Snapshot<T>::Error(void) const
+	{
+		return error;
+	}
+
+	template<class T>
+	int Snapshot<T>::IndexCount(void) const
+	{
+		return header == NULL ? 0 : header->vertexCount;
+	}
+
+	template<class T>
+	int Snapshot<T>::EdgeCount(void) const
+	{
+		return header == NULL ? 0 : header->edgeCount;
+	}
+
+	template<class T>
+	bool Snapshot<T>::IsPresent(int vertex) const
+	{
+		return present[vertex] != 0;
+	}
+
+	template<class T>
+	int Snapshot<T>::EdgesBegin(int vertex) const
+	{
+		return offsets[vertex];
+	}
+
+	template<class T>
+	int Snapshot<T>::Target(int edge) const
+	{
+		return targets[edge];
+	}
+
+	template<class T>
+	int Snapshot<T>::Weight(int edge) const
+	{
+		return weights[edge];
+	}
+
+	template<class T>
+	T Snapshot<T>::Get(int vertex) const
+	{
+		return SnapshotPayload<T>::Read(payload + payloadOffsets[vertex], payloadOffsets[vertex + 1] - payloadOffsets[vertex]);
+	}
+
+	template<class T>
+	std::queue<int> Snapshot<T>::ShortestPath(int source, int target)
+	{
+		std::list<int>	shortestPathList;	// The found shortest path.
+		std::queue<int>	shortestPath;		// The found shortest path (clean).
+
+		searchState.Reset(IndexCount());
+
+		/*
+		Walk the parents back from the target; an unreached target yields an empty path.
+		*/
+		if (!SearchRows<boost::int32_t>(searchState, offsets, targets, weights, source, target))
+			return shortestPath;
+		for (int i = target; i != -1; i = searchState.Parent(i))
+			shortestPathList.push_front(i);
+		for (std::list<int>::iterator i = shortestPathList.begin(); i != shortestPathList.end(); i++)
+			shortestPath.push(*i);
+		return shortestPath;
+	}
+
+	template<class T>
+	bool Snapshot<T>::Fail(const std::string &message)
+	{
+		error = message;
+		header = NULL;
+		file.Close();
+		return false;
+	}
+
+	template<class T>
+	bool Snapshot<T>::Contains(boost::uint64_t offset, boost::uint64_t size) const
+	{
+		return offset % 8 == 0 && offset <= file.Size() && size <= file.Size() - offset;
+	}
+}
+
+#endif
@@ -0,0 +1,443 @@
+//
+// C++ Interface: stats
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHSTATS_H
+#define GRAPHSTATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <boost/atomic.hpp>
+#ifdef GRAPHS_INSTRUMENT
+#include <boost/chrono.hpp>
+#endif
+
+#include "searchstate.h"
+
+namespace Graphs
+{
+	/**
+	@class LatencyHistogram stats.h
+	@brief Counts query times in logarithmic buckets without a lock.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Every power of two nanoseconds is split into four buckets, so a bucket
+	is never more than a quarter of its lower bound wide and any time up to
+	centuries fits in Buckets counters. Record() is a handful of relaxed
+	atomic additions, so any number of threads may record and read at once;
+	a reader racing a writer may just see a time counted but not yet summed.
+	*/
+	class LatencyHistogram
+	{
+		public:
+			static const int	Buckets = 256;	//!< The number of buckets.
+
+			/**
+			Constructor
+			*/
+			LatencyHistogram(void);
+
+			/**
+			@param nanoseconds How long a query took.
+			*/
+			void Record(unsigned long nanoseconds);
+
+			/**
+			@return The number of times recorded.
+			*/
+			unsigned long Count(void) const;
+
+			/**
+			@return The mean time in nanoseconds (0 if none were recorded).
+			*/
+			double Mean(void) const;
+
+			/**
+			@return The longest time recorded in nanoseconds.
+			*/
+			unsigned long Max(void) const;
+
+			/**
+			@param fraction How many of the times should be at or below the answer (0.5 for the median).
+			@return The upper bound of the bucket holding that time (or Max(), if less), in nanoseconds (0 if none were recorded).
+			*/
+			unsigned long Percentile(double fraction) const;
+
+			/**
+			@param bucket A bucket.
+			@return The number of times that fell in it.
+			*/
+			unsigned long BucketCount(int bucket) const;
+
+			/**
+			@param bucket A bucket.
+			@return The shortest time it holds, in nanoseconds.
+			*/
+			static unsigned long BucketFloor(int bucket);
+
+			/**
+			Forget everything recorded.
+			*/
+			void Reset(void);
+		private:
+			boost::atomic<unsigned long>	counts[Buckets];	//!< The times in each bucket.
+			boost::atomic<unsigned long>	count;				//!< The times recorded.
+			boost::atomic<unsigned long>	total;				//!< Their sum in nanoseconds.
+			boost::atomic<unsigned long>	longest;			//!< The longest of them.
+
+			/**
+			@param nanoseconds A time.
+			@return The bucket it falls in.
+			*/
+			static int Bucket(unsigned long nanoseconds);
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			LatencyHistogram(const LatencyHistogram &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			LatencyHistogram &operator=(const LatencyHistogram &);
+	};
+
+	/**
+	@class GraphStats stats.h
+	@brief The work and time of every query an engine has answered.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Only filled in when the library is built with GRAPHS_INSTRUMENT defined
+	(see Instrumented); otherwise every figure stays zero and the queries pay
+	nothing for it. The totals are summed from each query's SearchCounters
+	with relaxed atomics, so concurrent queries (ShortestPaths() workers, or
+	threads each with their own SearchState) may share one GraphStats. To
+	see what one slow query did, read Counters() off the SearchState it ran
+	in right after it returns.
+
+	Graph, FrozenGraph and ContractionHierarchy each keep one (see their
+	Stats()), fed by every point to point query and shortest path tree.
+	Every other search built on a SearchState counts its work there too,
+	but isn't timed. DeltaStepping and BreadthFirst keep their own parallel
+	frontiers and aren't counted at all; time them from outside.
+	*/
+	class GraphStats
+	{
+		public:
+			/**
+			Constructor
+			*/
+			GraphStats(void);
+
+			/**
+			@param counters The work a query did.
+			@param nanoseconds How long it took.
+			*/
+			void Record(const SearchCounters &counters, unsigned long nanoseconds);
+
+			/**
+			@return The number of queries answered.
+			*/
+			unsigned long Queries(void) const;
+
+			/**
+			@return The vertices settled across every query.
+			*/
+			unsigned long Settled(void) const;
+
+			/**
+			@return The edges relaxed across every query.
+			*/
+			unsigned long Relaxed(void) const;
+
+			/**
+			@return The frontier pushes across every query.
+			*/
+			unsigned long Pushes(void) const;
+
+			/**
+			@return The frontier pops across every query.
+			*/
+			unsigned long Pops(void) const;
+
+			/**
+			@return The decrease-keys across every query.
+			*/
+			unsigned long Decreases(void) const;
+
+			/**
+			@return How long the queries took.
+			*/
+			const LatencyHistogram &Latencies(void) const;
+
+			/**
+			Start counting again from zero.
+			*/
+			void Reset(void);
+		private:
+			boost::atomic<unsigned long>	queries;	//!< Queries answered.
+			boost::atomic<unsigned long>	settled;	//!< Vertices settled.
+			boost::atomic<unsigned long>	relaxed;	//!< Edges relaxed.
+			boost::atomic<unsigned long>	pushes;		//!< Frontier pushes.
+			boost::atomic<unsigned long>	pops;		//!< Frontier pops.
+			boost::atomic<unsigned long>	decreases;	//!< Decrease-keys.
+			LatencyHistogram				latencies;	//!< Time per query.
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			GraphStats(const GraphStats &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			GraphStats &operator=(const GraphStats &);
+	};
+
+	/**
+	@class QueryTimer stats.h
+	@brief Times one query and adds it to a GraphStats when it goes out of scope.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Does nothing at all unless Instrumented, so a query may keep one on the
+	stack unconditionally. The SearchStates are read when the timer goes, so
+	the query may Reset() them after the timer starts.
+	*/
+	class QueryTimer
+	{
+		public:
+			/**
+			@param stats Where the query is counted.
+			@param searchState The scratch space the query runs in.
+			@param otherState The scratch space of a bidirectional query's second search (NULL if none).
+
+			Constructor
+			*/
+			QueryTimer(GraphStats &stats, const SearchState &searchState, const SearchState *otherState = NULL);
+
+			/**
+			Destructor
+			*/
+			~QueryTimer(void);
+		private:
+#ifdef GRAPHS_INSTRUMENT
+			typedef boost::chrono::steady_clock	Clock;	//!< What queries are timed with.
+
+			Clock::time_point		start;			//!< When the query started.
+#endif
+			GraphStats				&stats;			//!< Where the query is counted.
+			const SearchState		&searchState;	//!< The scratch space the query runs in.
+			const SearchState		*otherState;	//!< The second search's, if any.
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			QueryTimer(const QueryTimer &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			QueryTimer &operator=(const QueryTimer &);
+	};
+
+	/*
+	LatencyHistogram
+	*/
+
+	inline LatencyHistogram::LatencyHistogram(void)
+	:count(0), total(0), longest(0)
+	{
+		for (int i = 0; i < Buckets; i++)
+			counts[i].store(0, boost::memory_order_relaxed);
+	}
+
+	inline void LatencyHistogram::Record(unsigned long nanoseconds)
+	{
+		unsigned long	seen = longest.load(boost::memory_order_relaxed);	// The longest so far.
+
+		counts[Bucket(nanoseconds)].fetch_add(1, boost::memory_order_relaxed);
+		count.fetch_add(1, boost::memory_order_relaxed);
+		total.fetch_add(nanoseconds, boost::memory_order_relaxed);
+		while (nanoseconds > seen && !longest.compare_exchange_weak(seen, nanoseconds, boost::memory_order_relaxed))
+			;
+		return;
+	}
+
+	inline unsigned long LatencyHistogram::Count(void) const
+	{
+		return count.load(boost::memory_order_relaxed);
+	}
+
+	inline double LatencyHistogram::Mean(void) const
+	{
+		const unsigned long	times = Count();	// Times recorded.
+
+		return times == 0 ? 0 : static_cast<double>(total.load(boost::memory_order_relaxed)) / times;
+	}
+
+	inline unsigned long LatencyHistogram::Max(void) const
+	{
+		return longest.load(boost::memory_order_relaxed);
+	}
+
+	inline unsigned long LatencyHistogram::Percentile(double fraction) const
+	{
+		unsigned long	seen = 0,	// Times in the buckets passed so far.
+						wanted;		// Times that must be at or below the answer.
+		const unsigned long	times = Count();
+
+		if (times == 0)
+			return 0;
+		/*
+		The rank is rounded up (p99 of 150 times is the 149th), less a hair
+		so that products like 0.07 * 100 don't round up past a whole rank.
+		*/
+		wanted = static_cast<unsigned long>(std::ceil(fraction * times - 1e-9));
+		wanted = std::max(1UL, std::min(wanted, times));
+		for (int i = 0; i < Buckets - 1; i++)
+		{
+			seen += BucketCount(i);
+			if (seen >= wanted)
+				return std::min(BucketFloor(i + 1) - 1, Max());
+		}
+		return Max();
+	}
+
+	inline unsigned long LatencyHistogram::BucketCount(int bucket) const
+	{
+		return counts[bucket].load(boost::memory_order_relaxed);
+	}
+
+	inline unsigned long LatencyHistogram::BucketFloor(int bucket)
+	{
+		/*
+		The first four buckets hold 0 through 3 exactly; after that bucket
+		4 * (k - 1) + q starts at (4 + q) * 2^(k - 2).
+		*/
+		if (bucket < 4)
+			return bucket;
+		return static_cast<unsigned long>(4 + bucket % 4) << (bucket / 4 - 1);
+	}
+
+	inline void LatencyHistogram::Reset(void)
+	{
+		for (int i = 0; i < Buckets; i++)
+			counts[i].store(0, boost::memory_order_relaxed);
+		count.store(0, boost::memory_order_relaxed);
+		total.store(0, boost::memory_order_relaxed);
+		longest.store(0, boost::memory_order_relaxed);
+		return;
+	}
+
+	inline int LatencyHistogram::Bucket(unsigned long nanoseconds)
+	{
+		int	power = 0;	// The highest set bit.
+
+		if (nanoseconds < 4)
+			return nanoseconds;
+		for (unsigned long i = nanoseconds; i > 1; i >>= 1)
+			power++;
+		return 4 * (power - 1) + ((nanoseconds >> (power - 2)) & 3);
+	}
+
+	/*
+	GraphStats
+	*/
+
+	inline GraphStats::GraphStats(void)
+	:queries(0), settled(0), relaxed(0), pushes(0), pops(0), decreases(0), latencies()
+	{
+	}
+
+	inline void GraphStats::Record(const SearchCounters &counters, unsigned long nanoseconds)
+	{
+		queries.fetch_add(1, boost::memory_order_relaxed);
+		settled.fetch_add(counters.settled, boost::memory_order_relaxed);
+		relaxed.fetch_add(counters.relaxed, boost::memory_order_relaxed);
+		pushes.fetch_add(counters.pushes, boost::memory_order_relaxed);
+		pops.fetch_add(counters.pops, boost::memory_order_relaxed);
+		decreases.fetch_add(counters.decreases, boost::memory_order_relaxed);
+		latencies.Record(nanoseconds);
+		return;
+	}
+
+	inline unsigned long GraphStats::Queries(void) const
+	{
+		return queries.load(boost::memory_order_relaxed);
+	}
+
+	inline unsigned long GraphStats::Settled(void) const
+	{
+		return settled.load(boost::memory_order_relaxed);
+	}
+
+	inline unsigned long GraphStats::Relaxed(void) const
+	{
+		return relaxed.load(boost::memory_order_relaxed);
+	}
+
+	inline unsigned long GraphStats::Pushes(void) const
+	{
+		return pushes.load(boost::memory_order_relaxed);
+	}
+
+	inline unsigned long GraphStats::Pops(void) const
+	{
+		return pops.load(boost::memory_order_relaxed);
+	}
+
+	inline unsigned long GraphStats::Decreases(void) const
+	{
+		return decreases.load(boost::memory_order_relaxed);
+	}
+
+	inline const LatencyHistogram &GraphStats::Latencies(void) const
+	{
+		return latencies;
+	}
+
+	inline void GraphStats::Reset(void)
+	{
+		queries.store(0, boost::memory_order_relaxed);
+		settled.store(0, boost::memory_order_relaxed);
+		relaxed.store(0, boost::memory_order_relaxed);
+		pushes.store(0, boost::memory_order_relaxed);
+		pops.store(0, boost::memory_order_relaxed);
+		decreases.store(0, boost::memory_order_relaxed);
+		latencies.Reset();
+		return;
+	}
+
+	/*
+	QueryTimer
+	*/
+
+	inline QueryTimer::QueryTimer(GraphStats &stats, const SearchState &searchState, const SearchState *otherState)
+#ifdef GRAPHS_INSTRUMENT
+	:start(Clock::now()), stats(stats), searchState(searchState), otherState(otherState)
+#else
+	:stats(stats), searchState(searchState), otherState(otherState)
+#endif
+	{
+	}
+
+	inline QueryTimer::~QueryTimer(void)
+	{
+#ifdef GRAPHS_INSTRUMENT
+		SearchCounters	counters = searchState.Counters();	// The query's work.
+
+		if (otherState != NULL)
+			counters.Add(otherState->Counters());
+		stats.Record(counters, boost::chrono::duration_cast<boost::chrono::nanoseconds>(Clock::now() - start).count());
+#endif
+	}
+}
+
+#endif
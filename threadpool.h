@@ -0,0 +1,166 @@
+//
+// C++ Interface: threadpool
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHTHREADPOOL_H
+#define GRAPHTHREADPOOL_H
+
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace Graphs
+{
+	/**
+	@class ThreadPool threadpool.h
+	@brief A fixed team of worker threads that run jobs together.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	Run() hands the same job to every worker, numbered 0 through Size() - 1,
+	and returns once they have all finished with it; the calling thread does
+	the work of worker 0. The threads live as long as the pool, so a run
+	costs a wake up rather than a thread start. Jobs split the work among
+	themselves, usually by claiming pieces off a shared atomic counter.
+	Only one Run() may be in progress at a time.
+	*/
+	class ThreadPool
+	{
+		public:
+			/**
+			@param size The number of workers (0 for one per hardware thread).
+
+			Constructor
+			*/
+			explicit ThreadPool(int size = 0);
+
+			/**
+			Destructor
+			*/
+			~ThreadPool(void);
+
+			/**
+			@return The number of workers.
+			*/
+			int Size(void) const;
+
+			/**
+			@param job Called as job(worker) on every worker.
+			*/
+			void Run(const boost::function<void (int)> &job);
+
+		private:
+			boost::thread_group					threads;	//!< Workers 1 through Size() - 1.
+			boost::mutex						mutex;		//!< Guards everything below.
+			boost::condition_variable			started;	//!< Signalled when there's a new job (or we're stopping).
+			boost::condition_variable			finished;	//!< Signalled when the last worker finishes a job.
+			const boost::function<void (int)>	*job;		//!< The job being run.
+			unsigned int						generation;	//!< Counts the jobs handed out.
+			int									running;	//!< Workers still busy with the job.
+			int									size;		//!< The number of workers.
+			bool								stopping;	//!< Are we shutting down?
+
+			/**
+			@param worker The worker's number.
+
+			What each thread does: wait for a job, run it, repeat.
+			*/
+			void Work(int worker);
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			ThreadPool(const ThreadPool &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			ThreadPool &operator=(const ThreadPool &);
+	};
+
+	inline ThreadPool::ThreadPool(int size)
+	:threads(), mutex(), started(), finished(), job(NULL), generation(0), running(0), size(size > 0 ? size : boost::thread::hardware_concurrency()), stopping(false)
+	{
+		if (this->size < 1)
+			this->size = 1;
+		for (int i = 1; i < this->size; i++)
+			threads.create_thread(boost::bind(&ThreadPool::Work, this, i));
+	}
+
+	inline ThreadPool::~ThreadPool(void)
+	{
+		{
+			boost::mutex::scoped_lock	lock(mutex);
+
+			stopping = true;
+		}
+		started.notify_all();
+		threads.join_all();
+	}
+
+	inline int ThreadPool::Size(void) const
+	{
+		return size;
+	}
+
+	inline void ThreadPool::Run(const boost::function<void (int)> &job)
+	{
+		{
+			boost::mutex::scoped_lock	lock(mutex);
+
+			this->job = &job;
+			running = size;
+			generation++;
+		}
+		started.notify_all();
+
+		job(0);
+
+		boost::mutex::scoped_lock	lock(mutex);
+
+		if (--running > 0)
+			while (running > 0)
+				finished.wait(lock);
+		this->job = NULL;
+		return;
+	}
+
+	inline void ThreadPool::Work(int worker)
+	{
+		unsigned int	seen = 0;	// The last job this worker ran.
+
+		for (;;)
+		{
+			const boost::function<void (int)>	*current;	// The job to run.
+
+			{
+				boost::mutex::scoped_lock	lock(mutex);
+
+				while (!stopping && generation == seen)
+					started.wait(lock);
+				if (stopping)
+					return;
+				seen = generation;
+				current = job;
+			}
+
+			(*current)(worker);
+
+			boost::mutex::scoped_lock	lock(mutex);
+
+			if (--running == 0)
+				finished.notify_one();
+		}
+	}
+}
+
+#endif
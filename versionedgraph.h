@@ -0,0 +1,560 @@
+//
+// C++ Interface: versionedgraph
+//
+// Description:
+//
+//
+// Author: Alex Brandt <alunduil@alunduil.com>, (C) 2007
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef GRAPHVERSIONEDGRAPH_H
+#define GRAPHVERSIONEDGRAPH_H
+
+#include <vector>
+#include <list>
+#include <queue>
+#include <utility>
+#include <limits>
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_array.hpp>
+
+#include "graph.h"
+#include "graphlistener.h"
+#include "searchstate.h"
+
+namespace Graphs
+{
+	/**
+	@class VersionedGraph versionedgraph.h
+	@brief Lock free readers of a Graph that another thread keeps changing.
+	@author Alex Brandt <alunduil@alunduil.com>
+
+	The Graph itself isn't safe to read while it changes. This listens to it
+	and publishes immutable Versions of its adjacency that any number of
+	reader threads can search while the one thread that owns the Graph goes
+	on changing it.
+
+	A Version is a table of blocks, each holding the rows of BlockSize
+	consecutive vertices as compressed sparse rows. A change rebuilds only
+	the blocks it touched; the rest are shared with the Version before, so
+	publishing costs the touched rows plus a copy of the table. Publishing is
+	a single atomic store: a reader sees the whole of a Version or none of
+	it. By default every change is published as it happens; Defer() collects
+	them until Publish(), so a batch of changes appears at once.
+
+	Old Versions are reclaimed by epoch. A reader announces the epoch when it
+	pins a Version (one atomic store, no lock, no waiting on the writer) and
+	clears it when done. Each Version replaced is stamped with the epoch
+	that follows it, and freed once no reader is pinned at an earlier epoch,
+	since any later reader can only have seen its successor. A reader that
+	stays pinned only holds memory back; it never holds the writer up.
+
+	Readers are numbered, like the workers of a ThreadPool, and each number
+	may only be used by one thread at a time. Searches return dense
+	identifiers rather than vertices, since the vertex may be deleted from
+	the Graph while the path is still being read.
+	*/
+	template<class T>
+	class VersionedGraph : public GraphListener<T>
+	{
+		public:
+			static const int	BlockSize = 64;		//!< Vertices per block.
+
+			/**
+			@class Version versionedgraph.h
+			@brief The adjacency of the Graph as it was when published. Never changes.
+			*/
+			class Version
+			{
+				public:
+					/**
+					@return How many Versions were published before this one.
+					*/
+					int Number(void) const;
+
+					/**
+					@return One past the largest vertex identifier in this Version.
+					*/
+					int IndexCount(void) const;
+
+					/**
+					@param vertex The dense identifier of a vertex.
+					@return The number of edges leaving it.
+					*/
+					int Degree(int vertex) const;
+
+					/**
+					@param source The dense identifier of the source vertex.
+					@param target The dense identifier of the destination vertex.
+					@param searchState The scratch space to search in (the reader's own).
+					@return The dense identifiers along the shortest path (empty if the target can't be reached).
+
+					Dijkstra's shortest path over the blocks, counting every edge as one if the Graph is Unweighted.
+					*/
+					std::queue<int> ShortestPath(int source, int target, SearchState &searchState) const;
+
+				private:
+					friend class VersionedGraph<T>;
+
+					/**
+					@brief The rows of BlockSize consecutive vertices.
+					*/
+					struct Block
+					{
+						std::vector<int>	offsets;	//!< Where each row starts (one extra entry closes the last row).
+						std::vector<int>	targets;	//!< The end of each edge.
+						std::vector<int>	weights;	//!< The weight of each edge.
+
+						/**
+						Constructor
+						*/
+						Block(void);
+					};
+
+					std::vector<boost::shared_ptr<const Block> >	blocks;	//!< The rows, shared with the Versions either side.
+					int												count;	//!< One past the largest vertex identifier.
+					int												number;	//!< Versions published before this one.
+
+					/**
+					Constructor
+					*/
+					Version(void);
+			};
+
+			/**
+			@param graph The Graph to publish.
+			@param readers The number of reader threads.
+
+			Constructor
+			*/
+			VersionedGraph(Graph<T> &graph, int readers);
+
+			/**
+			Destructor (no reader may be pinned)
+			*/
+			~VersionedGraph(void);
+
+			/**
+			@param reader The reader's number.
+			@return The latest Version, which stays valid until Unpin().
+			@sa Unpin()
+
+			Safe from any thread, at any time, without locking.
+			*/
+			const Version &Pin(int reader);
+
+			/**
+			@param reader The reader's number.
+			@sa Pin()
+			*/
+			void Unpin(int reader);
+
+			/**
+			@param reader The reader's number.
+			@param source The dense identifier of the source vertex.
+			@param target The dense identifier of the destination vertex.
+			@param searchState The scratch space to search in (the reader's own).
+			@return The dense identifiers along the shortest path in the latest Version.
+
+			Pin, search and unpin.
+			*/
+			std::queue<int> ShortestPath(int reader, int source, int target, SearchState &searchState);
+
+			/**
+			@param defer Hold changes back until Publish()?
+
+			Only the thread changing the Graph may call this.
+			*/
+			void Defer(bool defer = true);
+
+			/**
+			Make every change so far visible to readers at once. Only the thread changing the Graph may call this.
+			*/
+			void Publish(void);
+
+			/**
+			@return The number of replaced Versions some reader may still be using.
+			*/
+			int Retired(void) const;
+
+			/**
+			@param vertex The vertex that was just inserted.
+			*/
+			void VertexInserted(Vertex<T> &vertex);
+
+			/**
+			@param vertex The vertex about to be deleted.
+			*/
+			void VertexDeleted(const Vertex<T> &vertex);
+
+			/**
+			@param from Where the new edge starts.
+			@param to Where the new edge ends.
+			@param weight The weight of the new edge.
+			*/
+			void EdgeInserted(Vertex<T> &from, Vertex<T> &to, int weight);
+
+			/**
+			@param from Where the deleted edges started.
+			@param to Where the deleted edges ended.
+			*/
+			void EdgeDeleted(Vertex<T> &from, Vertex<T> &to);
+
+			/**
+			@param from Where the edge starts.
+			@param to Where the edge ends.
+			@param oldWeight The weight it had.
+			@param newWeight The weight it has now.
+			*/
+			void WeightChanged(Vertex<T> &from, Vertex<T> &to, int oldWeight, int newWeight);
+
+		private:
+			typedef typename Version::Block	Block;	//!< The rows of BlockSize consecutive vertices.
+
+			/**
+			@brief A reader's announced epoch, alone on its cache line.
+			*/
+			struct Slot
+			{
+				boost::atomic<unsigned long>	epoch;										//!< The epoch the reader pinned at (0 when not pinned).
+				char							padding[64 - sizeof(boost::atomic<unsigned long>)];	//!< Keeps readers from sharing a line.
+
+				/**
+				Constructor
+				*/
+				Slot(void);
+			};
+
+			Graph<T>										&graph;		//!< The Graph being published.
+			boost::atomic<const Version*>					current;	//!< The latest Version.
+			boost::atomic<unsigned long>					epoch;		//!< Bumped every time a Version is replaced.
+			int												readers;	//!< The number of reader threads.
+			boost::scoped_array<Slot>						slots;		//!< Each reader's announced epoch.
+			std::list<std::pair<unsigned long, const Version*> >	retired;	//!< Replaced Versions and the epoch that followed them.
+			std::vector<int>								dirty;		//!< The blocks changed since the last Publish().
+			std::vector<bool>								marked;		//!< Is each block in dirty?
+			bool											deferring;	//!< Are changes held until Publish()?
+			int												deleted;	//!< The vertex being deleted (-1 if none).
+
+			/**
+			@param vertex The dense identifier of a vertex whose edges changed.
+			*/
+			void Touch(int vertex);
+
+			/**
+			Publish now, unless changes are being deferred.
+			*/
+			void Changed(void);
+
+			/**
+			@param block The block's number.
+			@return Its rows, as the Graph has them now.
+			*/
+			boost::shared_ptr<const Block> Build(int block) const;
+
+			/**
+			Free the replaced Versions no reader can still be using.
+			*/
+			void Reclaim(void);
+
+			/**
+			Copy Constructor (not allowed)
+			*/
+			VersionedGraph(const VersionedGraph &);
+
+			/**
+			Assignment Operator (not allowed)
+			*/
+			VersionedGraph &operator=(const VersionedGraph &);
+	};
+
+	template<class T>
+	VersionedGraph<T>::Version::Block::Block(void)
+	:offsets(std::vector<int>()), targets(std::vector<int>()), weights(std::vector<int>())
+	{
+	}
+
+	template<class T>
+	VersionedGraph<T>::Version::Version(void)
+	:blocks(std::vector<boost::shared_ptr<const Block> >()), count(0), number(0)
+	{
+	}
+
+	template<class T>
+	int VersionedGraph<T>::Version::Number(void) const
+	{
+		return number;
+	}
+
+	template<class T>
+	int VersionedGraph<T>::Version::IndexCount(void) const
+	{
+		return count;
+	}
+
+	template<class T>
+	int VersionedGraph<T>::Version::Degree(int vertex) const
+	{
+		const Block	&block = *blocks[vertex / BlockSize];	// Where the vertex's row is.
+
+		return block.offsets[vertex % BlockSize + 1] - block.offsets[vertex % BlockSize];
+	}
+
+	template<class T>
+	std::queue<int> VersionedGraph<T>::Version::ShortestPath(int source, int target, SearchState &searchState) const
+	{
+		using namespace std;
+
+		list<int>	shortestPathList;	// The found shortest path.
+		queue<int>	shortestPath;		// The found shortest path (clean).
+
+		if (source < 0 || source >= count || target < 0 || target >= count)
+			return shortestPath;
+
+		searchState.Reset(count);
+		searchState.Improve(source, 0, -1);
+		for (int current = searchState.Settle(); current != -1 && current != target; current = searchState.Settle())
+		{
+			const Block	&block = *blocks[current / BlockSize];	// Where the current row is.
+			const int	row = current % BlockSize,
+						currentDistance = searchState.Distance(current);
+
+			for (int edge = block.offsets[row]; edge < block.offsets[row + 1]; edge++)
+				searchState.Improve(block.targets[edge], currentDistance + block.weights[edge], current);
+		}
+		if (!searchState.IsSettled(target))
+			return shortestPath;
+
+		for (int i = target; i != -1; i = searchState.Parent(i))
+			shortestPathList.push_front(i);
+		for (list<int>::iterator i = shortestPathList.begin(); i != shortestPathList.end(); i++)
+			shortestPath.push(*i);
+		return shortestPath;
+	}
+
+	template<class T>
+	VersionedGraph<T>::Slot::Slot(void)
+	:epoch(0), padding()
+	{
+	}
+
+	template<class T>
+	VersionedGraph<T>::VersionedGraph(Graph<T> &graph, int readers)
+	:GraphListener<T>(), graph(graph), current(NULL), epoch(1), readers(readers > 0 ? readers : 1), slots(new Slot[readers > 0 ? readers : 1]), retired(std::list<std::pair<unsigned long, const Version*> >()), dirty(std::vector<int>()), marked(std::vector<bool>()), deferring(false), deleted(-1)
+	{
+		/*
+		The first Version starts with no blocks; Publish() builds every one it's missing.
+		*/
+		current.store(new Version());
+		Publish();
+		graph.Attach(*this);
+	}
+
+	template<class T>
+	VersionedGraph<T>::~VersionedGraph(void)
+	{
+		graph.Detach(*this);
+		for (typename std::list<std::pair<unsigned long, const Version*> >::iterator i = retired.begin(); i != retired.end(); i++)
+			delete i->second;
+		delete current.load();
+	}
+
+	template<class T>
+	const typename VersionedGraph<T>::Version &VersionedGraph<T>::Pin(int reader)
+	{
+		/*
+		Announce first, then look: if the writer replaced the Version we find
+		before we announced, the announcement is at the new epoch or earlier,
+		and either way the writer sees it before freeing what we found.
+		*/
+		slots[reader].epoch.store(epoch.load());
+		return *current.load();
+	}
+
+	template<class T>
+	void VersionedGraph<T>::Unpin(int reader)
+	{
+		slots[reader].epoch.store(0);
+		return;
+	}
+
+	template<class T>
+	std::queue<int> VersionedGraph<T>::ShortestPath(int reader, int source, int target, SearchState &searchState)
+	{
+		std::queue<int>	shortestPath = Pin(reader).ShortestPath(source, target, searchState);	// Found while pinned.
+
+		Unpin(reader);
+		return shortestPath;
+	}
+
+	template<class T>
+	void VersionedGraph<T>::Defer(bool defer)
+	{
+		deferring = defer;
+		return;
+	}
+
+	template<class T>
+	void VersionedGraph<T>::Publish(void)
+	{
+		const Version	*old = current.load();				// The Version being replaced.
+		Version			*next = new Version(*old);			// Shares every block with it to begin with.
+
+		next->count = graph.IndexCount();
+		next->number = old->number + 1;
+		next->blocks.resize((next->count + BlockSize - 1) / BlockSize);
+		for (std::vector<int>::iterator i = dirty.begin(); i != dirty.end(); i++)
+		{
+			if (*i < static_cast<int>(next->blocks.size()))
+				next->blocks[*i] = Build(*i);
+			marked[*i] = false;
+		}
+		dirty.clear();
+		for (std::size_t i = 0; i < next->blocks.size(); i++)
+			if (!next->blocks[i])
+				next->blocks[i] = Build(i);
+
+		current.store(next);
+		retired.push_back(std::make_pair(++epoch, old));
+		Reclaim();
+		return;
+	}
+
+	template<class T>
+	int VersionedGraph<T>::Retired(void) const
+	{
+		return retired.size();
+	}
+
+	template<class T>
+	void VersionedGraph<T>::VertexInserted(Vertex<T> &vertex)
+	{
+		Touch(vertex.Index());
+		Changed();
+		return;
+	}
+
+	template<class T>
+	void VersionedGraph<T>::VertexDeleted(const Vertex<T> &vertex)
+	{
+		/*
+		The Graph drops the vertex's edges after telling us, so a Version
+		published now leaves them out by hand.
+		*/
+		deleted = vertex.Index();
+		Touch(deleted);
+		for (typename Vertex<T>::EdgeIterator i = graph.InEdgesBegin(vertex); i != graph.InEdgesEnd(vertex); i++)
+			Touch(boost::get<0>(*i)->Index());
+		Changed();
+		deleted = -1;
+		return;
+	}
+
+	template<class T>
+	void VersionedGraph<T>::EdgeInserted(Vertex<T> &from, Vertex<T> &to, int)
+	{
+		Touch(from.Index());
+		if (!graph.IsDirected())
+			Touch(to.Index());
+		Changed();
+		return;
+	}
+
+	template<class T>
+	void VersionedGraph<T>::EdgeDeleted(Vertex<T> &from, Vertex<T> &to)
+	{
+		Touch(from.Index());
+		if (!graph.IsDirected())
+			Touch(to.Index());
+		Changed();
+		return;
+	}
+
+	template<class T>
+	void VersionedGraph<T>::WeightChanged(Vertex<T> &from, Vertex<T> &to, int, int)
+	{
+		Touch(from.Index());
+		if (!graph.IsDirected())
+			Touch(to.Index());
+		Changed();
+		return;
+	}
+
+	template<class T>
+	void VersionedGraph<T>::Touch(int vertex)
+	{
+		const int	block = vertex / BlockSize;	// The block the vertex's row is in.
+
+		if (block >= static_cast<int>(marked.size()))
+			marked.resize(block + 1, false);
+		if (!marked[block])
+		{
+			marked[block] = true;
+			dirty.push_back(block);
+		}
+		return;
+	}
+
+	template<class T>
+	void VersionedGraph<T>::Changed(void)
+	{
+		if (!deferring)
+			Publish();
+		return;
+	}
+
+	template<class T>
+	boost::shared_ptr<const typename VersionedGraph<T>::Block> VersionedGraph<T>::Build(int block) const
+	{
+		Block		*rows = new Block();	// The new rows.
+		const int	first = block * BlockSize,
+					last = std::min(first + BlockSize, graph.IndexCount());
+
+		rows->offsets.reserve(BlockSize + 1);
+		rows->offsets.push_back(0);
+		for (int i = first; i < first + BlockSize; i++)
+		{
+			Vertex<T>	*vertex = i < last && i != deleted ? graph.VertexAt(i) : NULL;	// NULL rows stay empty.
+
+			if (vertex != NULL)
+				for (typename Vertex<T>::EdgeIterator j = vertex->EdgesBegin(); j != vertex->EdgesEnd(); j++)
+					if (boost::get<0>(*j)->Index() != deleted)
+					{
+						rows->targets.push_back(boost::get<0>(*j)->Index());
+						rows->weights.push_back(graph.IsWeighted() ? boost::get<1>(*j) : 1);
+					}
+			rows->offsets.push_back(rows->targets.size());
+		}
+		return boost::shared_ptr<const Block>(rows);
+	}
+
+	template<class T>
+	void VersionedGraph<T>::Reclaim(void)
+	{
+		unsigned long	oldest = std::numeric_limits<unsigned long>::max();	// The earliest epoch a reader is pinned at.
+
+		for (int i = 0; i < readers; i++)
+		{
+			const unsigned long	pinned = slots[i].epoch.load();
+
+			if (pinned != 0 && pinned < oldest)
+				oldest = pinned;
+		}
+
+		/*
+		A Version stamped e was replaced before epoch e began, so a reader
+		pinned at e or later can't have it.
+		*/
+		while (!retired.empty() && retired.front().first <= oldest)
+		{
+			delete retired.front().second;
+			retired.pop_front();
+		}
+		return;
+	}
+}
+
+#endif
@@ -18,11 +18,17 @@
 #include <boost/lambda/lambda.hpp>
 #include <boost/lambda/bind.hpp>
 #include <boost/lambda/if.hpp>
+#include <boost/unordered_map.hpp>
+#include <limits>
+
+#include "arena.h"
+#include "policy.h"
 
 namespace Graphs
 {
-	template<typename T> class Vertex;
-	template<typename T> std::ostream &operator<< (std::ostream &, const Vertex<T> &);
+	const int Infinity = std::numeric_limits<int>::max();
+
+	template<typename T, Weighting W, class WeightType> std::ostream &operator<< (std::ostream &, const Vertex<T, W, WeightType> &);
 
 	/**
 	@class Vertex vertex.h
@@ -30,11 +36,19 @@ namespace Graphs
 	@author Alex Brandt <alunduil@alunduil.com>
 
 	Vertex of a graph. Basically a node in the network. It's a wonderful day in the neighborhood...
+
+	W and WeightType follow the owning Graph's and decide how the edges are
+	kept (see EdgeStorage).
 	*/
-	template<typename T>
+	template<typename T, Weighting W, class WeightType>
 	class Vertex
 	{
 		public:
+			typedef EdgeStorage<Vertex, W, WeightType>			Storage;		//!< How the edges are kept.
+			typedef typename Storage::Edge						Edge;			//!< The end of an edge and (unless Unweighted) its weight.
+			typedef std::list<Edge, ArenaAllocator<Edge> >		EdgeList;		//!< The neighborhood, with nodes drawn from the Graph's Arena.
+			typedef typename EdgeList::const_iterator			EdgeIterator;	//!< Walks the neighborhood in place.
+
 			/**
 			@param mrRogers The data the vertex should hold.
 
@@ -47,7 +61,7 @@ namespace Graphs
 
 			Copy Constructor
 			*/
-			Vertex(const Vertex<T> &otherVertex);
+			Vertex(const Vertex<T, W, WeightType> &otherVertex);
 
 			/**
 			Destructor
@@ -59,7 +73,7 @@ namespace Graphs
 
 			Delete neighbor
 			*/
-			void DeleteNeighbor(const Vertex<T> &neighbor);
+			void DeleteNeighbor(const Vertex<T, W, WeightType> &neighbor);
 
 			/**
 			@param neighbor Please won't you be my neighbor?
@@ -67,7 +81,16 @@ namespace Graphs
 
 			Create neighbor
 			*/
-			void CreateNeighbor(const Vertex<T> &neighbor, const int weight = 1);
+			void CreateNeighbor(const Vertex<T, W, WeightType> &neighbor, const int weight = 1);
+
+			/**
+			@param neighbor The neighbor whose edges to change.
+			@param weight The new weight.
+			@return True if there was an edge to change.
+
+			Set the weight of every edge to neighbor.
+			*/
+			bool SetWeight(const Vertex<T, W, WeightType> &neighbor, const int weight);
 
 			/**
 			@return The data Mr. Rogers holds for us.
@@ -86,16 +109,45 @@ namespace Graphs
 			/**
 			@return The neighborhood.
 
-			Getting the neighborhood to play with.
+			Getting the neighborhood to play with (no copy is made).
 			*/
-			std::list<boost::tuple<Vertex<T>*, int> > Neighborhood(void);
+			const EdgeList &Neighborhood(void) const;
 
 			/**
 			@return The neighbors.
+			@sa EdgesBegin()
+
+			Collects the neighbors to play with. This builds a new list on every call; loops should walk EdgesBegin() to EdgesEnd() instead.
+			*/
+			std::list<Vertex<T, W, WeightType>*> Neighbors(void);
+
+			/**
+			@return Iterator to the first edge leaving this vertex.
+			@sa EdgesEnd()
 
-			Collects the neighbors to play with.
+			Walk the edges in place; boost::get<0>() of an edge is its end and boost::get<1>() its weight (Unweighted graphs keep only the end; see EdgeStorage).
 			*/
-			std::list<Vertex<T>*> Neighbors(void);
+			EdgeIterator EdgesBegin(void) const;
+
+			/**
+			@return Iterator one past the last edge leaving this vertex.
+			@sa EdgesBegin()
+			*/
+			EdgeIterator EdgesEnd(void) const;
+
+			/**
+			@return The number of edges leaving this vertex.
+			*/
+			int Degree(void) const;
+
+			/**
+			@param visitor Called as visitor(Vertex *end, int weight) for every edge leaving this vertex.
+			@return The visitor, like std::for_each.
+
+			Visit the edges with their weights already in hand.
+			*/
+			template<class Visitor>
+			Visitor ForEachEdge(Visitor visitor) const;
 
 			/**
 			@param that That vertex to compare.
@@ -103,7 +155,7 @@ namespace Graphs
 
 			Equivalency Operator
 			*/
-			bool operator==(const Vertex<T> &that) const;
+			bool operator==(const Vertex<T, W, WeightType> &that) const;
 
 			/**
 			@param that That vertex to compare.
@@ -111,7 +163,7 @@ namespace Graphs
 
 			Inequality Operator
 			*/
-			bool operator!=(const Vertex<T> &that) const;
+			bool operator!=(const Vertex<T, W, WeightType> &that) const;
 
 			/**
 			@param that That vertex to compare.
@@ -119,7 +171,7 @@ namespace Graphs
 
 			Greater than operator
 			*/
-			bool operator>(const Vertex<T> &that) const;
+			bool operator>(const Vertex<T, W, WeightType> &that) const;
 
 			/**
 			@param that That vertex to compare.
@@ -127,7 +179,7 @@ namespace Graphs
 
 			Greater than or equal operator.
 			*/
-			bool operator>=(const Vertex<T> &that) const;
+			bool operator>=(const Vertex<T, W, WeightType> &that) const;
 
 			/**
 			@param that That vertex to compare.
@@ -135,7 +187,7 @@ namespace Graphs
 
 			Less than operator.		outStream << otherVertex.mrRogers;
 			*/
-			bool operator<(const Vertex<T> &that) const;
+			bool operator<(const Vertex<T, W, WeightType> &that) const;
 
 			/**
 			@param that That vertex to compare.
@@ -143,7 +195,7 @@ namespace Graphs
 
 			Less than or equal operator.
 			*/
-			bool operator<=(const Vertex<T> &that) const;
+			bool operator<=(const Vertex<T, W, WeightType> &that) const;
 
 			/**
 			@param other The vertex to assign to this one.
@@ -151,7 +203,7 @@ namespace Graphs
 
 			Assignment Operator.
 			*/
-			Vertex<T> &operator=(const Vertex<T> &other);
+			Vertex<T, W, WeightType> &operator=(const Vertex<T, W, WeightType> &other);
 
 			/**
 			@param otherVertex That vertex to output to the stream.
@@ -164,15 +216,45 @@ namespace Graphs
 
 			/**
 			@param otherVertex The vertex to find the weight to.
-			@return The weight from this vertex to that vertex.
+			@return The weight from this vertex to that vertex (the first such edge), or Infinity if there isn't one.
+			@sa IndexWeights()
+
+			Grab the weight of the path. Linear in the degree unless the weights are indexed.
+			*/
+			int GetWeight(const Vertex<T, W, WeightType> &otherVertex) const;
 
-			Grab the weight of the path.
+			/**
+			@param enable Whether to keep the index.
+			@sa GetWeight()
+
+			Keep a hash from neighbor to weight alongside the neighborhood so GetWeight() is constant time.
+			Worth it for hubs; a waste of memory for the average vertex.
+			*/
+			void IndexWeights(bool enable = true);
+
+			/**
+			@return The dense identifier given by the owning Graph, or -1 if the vertex isn't in one.
+
+			Identifiers are handed out in insertion order and never reused, so they can index flat arrays.
 			*/
-			int GetWeight(const Vertex<T> &otherVertex) const;
+			int Index(void) const;
 
 		private:
-			std::list<boost::tuple<Vertex<T>*, int> >	neighborhood;	//!< Neighboring nodes in the graph. The list contains tuples that correspond the end of the edge to the weight of the edge.
+			template<class, Direction, Weighting, class> friend class Graph;
+
+			/**
+			@param otherVertex The other vertex to copy.
+			@param arena Where the copy's edges are allocated.
+
+			Copy Constructor used by the Graph to place its own vertices.
+			*/
+			Vertex(const Vertex<T, W, WeightType> &otherVertex, Arena &arena);
+
+			EdgeList									neighborhood;	//!< Neighboring nodes in the graph. The list contains tuples that correspond the end of the edge to the weight of the edge.
+			EdgeList									inEdges;		//!< The edges into this vertex, each as its start and weight (kept only by Directed Graphs).
 			T											mrRogers;		//!< The man himself to hold our dear data.
+			int											index;			//!< Dense identifier within the owning Graph.
+			boost::unordered_map<const Vertex<T, W, WeightType>*, int>	*weightIndex;	//!< Neighbor to weight of the first edge to it (NULL unless IndexWeights()).
 
 			/**
 			@param myTuple This static methods very own tuple.
@@ -180,7 +262,7 @@ namespace Graphs
 
 			Get the weight of the neighbor.
 			*/
-			static int GetWeightFromTuple(boost::tuple<Vertex<T>*, int> myTuple);
+			static int GetWeightFromTuple(const Edge &myTuple);
 
 			/**
 			@param myTuple The tuple[trunk] to extract our neighbor from.
@@ -188,149 +270,302 @@ namespace Graphs
 
 			Get the neighbor.
 			*/
-			static Vertex<T>* GetVertexFromTuple(boost::tuple<Vertex<T>*, int> myTuple);
+			static Vertex<T, W, WeightType>* GetVertexFromTuple(const Edge &myTuple);
 
+			/**
+			@param neighbor The start of the new edge in.
+			@param weight The weight of the edge.
+			*/
+			void CreateInNeighbor(const Vertex<T, W, WeightType> &neighbor, const int weight);
+
+			/**
+			@param neighbor The start of the edges in to forget.
+			*/
+			void DeleteInNeighbor(const Vertex<T, W, WeightType> &neighbor);
+
+			/**
+			@param neighbor The start of the edges in to change.
+			@param weight The new weight.
+			*/
+			void SetInWeight(const Vertex<T, W, WeightType> &neighbor, const int weight);
+
+			/**
+			@param edges The edges to look through.
+			@param neighbor The end to drop.
+
+			Erase every edge to neighbor in one pass.
+			*/
+			static void Erase(EdgeList &edges, const Vertex<T, W, WeightType> &neighbor);
 	};
 
-	template<typename T>
-	Vertex<T>::Vertex(T mrRogers)
-	:neighborhood(std::list<boost::tuple<Vertex<T>*, int> >()), mrRogers(mrRogers)
+	template<typename T, Weighting W, class WeightType>
+	Vertex<T, W, WeightType>::Vertex(T mrRogers)
+	:neighborhood(EdgeList()), inEdges(EdgeList()), mrRogers(mrRogers), index(-1), weightIndex(NULL)
 	{
 	}
 
-	template<typename T>
-	Vertex<T>::Vertex(const Vertex<T> &otherVertex)
-	:neighborhood(otherVertex.neighborhood), mrRogers(otherVertex.mrRogers)
+	template<typename T, Weighting W, class WeightType>
+	Vertex<T, W, WeightType>::Vertex(const Vertex<T, W, WeightType> &otherVertex)
+	:neighborhood(otherVertex.neighborhood.begin(), otherVertex.neighborhood.end(), ArenaAllocator<Edge>()), inEdges(EdgeList()), mrRogers(otherVertex.mrRogers), index(-1), weightIndex(NULL)
 	{
+		if (otherVertex.weightIndex != NULL)
+			weightIndex = new boost::unordered_map<const Vertex<T, W, WeightType>*, int>(*otherVertex.weightIndex);
 	}
 
-	template<typename T>
-	Vertex<T> &Vertex<T>::operator=(const Vertex<T> &other)
+	template<typename T, Weighting W, class WeightType>
+	Vertex<T, W, WeightType>::Vertex(const Vertex<T, W, WeightType> &otherVertex, Arena &arena)
+	:neighborhood(otherVertex.neighborhood.begin(), otherVertex.neighborhood.end(), ArenaAllocator<Edge>(&arena)), inEdges(ArenaAllocator<Edge>(&arena)), mrRogers(otherVertex.mrRogers), index(-1), weightIndex(NULL)
+	{
+		if (otherVertex.weightIndex != NULL)
+			weightIndex = new boost::unordered_map<const Vertex<T, W, WeightType>*, int>(*otherVertex.weightIndex);
+	}
+
+	template<typename T, Weighting W, class WeightType>
+	Vertex<T, W, WeightType> &Vertex<T, W, WeightType>::operator=(const Vertex<T, W, WeightType> &other)
 	{
 		if (this != &other)
 		{
 			this->neighborhood = other.neighborhood;
 			this->mrRogers = other.mrRogers;
+			IndexWeights(false);
+			IndexWeights(other.weightIndex != NULL);
 		}
 		return *this;
 	}
 
-	template<typename T>
-	Vertex<T>::~Vertex(void)
+	template<typename T, Weighting W, class WeightType>
+	Vertex<T, W, WeightType>::~Vertex(void)
+	{
+		delete weightIndex;
+	}
+
+	template<typename T, Weighting W, class WeightType>
+	void Vertex<T, W, WeightType>::CreateNeighbor(const Vertex<T, W, WeightType> &neighbor, const int weight)
+	{
+		neighborhood.insert(neighborhood.end(), Storage::Make(const_cast<Vertex<T, W, WeightType>*>(&neighbor), weight));
+		if (weightIndex != NULL)
+			weightIndex->insert(std::make_pair(&neighbor, weight));
+		return;
+	}
+
+	template<typename T, Weighting W, class WeightType>
+	bool Vertex<T, W, WeightType>::SetWeight(const Vertex<T, W, WeightType> &neighbor, const int weight)
+	{
+		bool	found = false;	// Was there an edge to neighbor?
+
+		for (typename EdgeList::iterator i = neighborhood.begin(); i != neighborhood.end(); i++)
+			if (boost::get<0>(*i) == &neighbor)
+			{
+				Storage::SetWeight(*i, weight);
+				found = true;
+			}
+		if (found && weightIndex != NULL)
+			(*weightIndex)[&neighbor] = weight;
+		return found;
+	}
+
+	template<typename T, Weighting W, class WeightType>
+	void Vertex<T, W, WeightType>::DeleteNeighbor(const Vertex<T, W, WeightType> &neighbor)
+	{
+		Erase(neighborhood, neighbor);
+		if (weightIndex != NULL)
+			weightIndex->erase(&neighbor);
+		return;
+	}
+
+	template<typename T, Weighting W, class WeightType>
+	void Vertex<T, W, WeightType>::CreateInNeighbor(const Vertex<T, W, WeightType> &neighbor, const int weight)
+	{
+		inEdges.insert(inEdges.end(), Storage::Make(const_cast<Vertex<T, W, WeightType>*>(&neighbor), weight));
+		return;
+	}
+
+	template<typename T, Weighting W, class WeightType>
+	void Vertex<T, W, WeightType>::DeleteInNeighbor(const Vertex<T, W, WeightType> &neighbor)
 	{
+		Erase(inEdges, neighbor);
+		return;
 	}
 
-	template<typename T>
-	void Vertex<T>::CreateNeighbor(const Vertex<T> &neighbor, const int weight)
+	template<typename T, Weighting W, class WeightType>
+	void Vertex<T, W, WeightType>::SetInWeight(const Vertex<T, W, WeightType> &neighbor, const int weight)
 	{
-		neighborhood.insert(neighborhood.end(), boost::tuple<Vertex<T>*, int>(const_cast<Vertex<T>*>(&neighbor), weight));
+		for (typename EdgeList::iterator i = inEdges.begin(); i != inEdges.end(); i++)
+			if (boost::get<0>(*i) == &neighbor)
+				Storage::SetWeight(*i, weight);
 		return;
 	}
 
-	template<typename T>
-	void Vertex<T>::DeleteNeighbor(const Vertex<T> &neighbor)
+	template<typename T, Weighting W, class WeightType>
+	void Vertex<T, W, WeightType>::Erase(EdgeList &edges, const Vertex<T, W, WeightType> &neighbor)
 	{
-		for (class std::list<boost::tuple<Vertex<T>*, int> >::iterator i = neighborhood.begin(); i != neighborhood.end(); i++)
-			if (boost::get<0>(*i) == boost::get<0>(neighbor))
-				neighborhood.erase(i);
+		for (typename EdgeList::iterator i = edges.begin(); i != edges.end();)
+			if (boost::get<0>(*i) == &neighbor)
+				i = edges.erase(i);
+			else
+				i++;
 		return;
 	}
 
-	template<typename T>
-	T Vertex<T>::Get(void) const
+	template<typename T, Weighting W, class WeightType>
+	T Vertex<T, W, WeightType>::Get(void) const
 	{
 		return mrRogers;
 	}
 
-	template<typename T>
-	void Vertex<T>::Set(T data)
+	template<typename T, Weighting W, class WeightType>
+	void Vertex<T, W, WeightType>::Set(T data)
 	{
 		mrRogers = data;
 		return;
 	}
 
-	template<typename T>
-	bool Vertex<T>::operator<=(const Vertex<T> &that) const
+	template<typename T, Weighting W, class WeightType>
+	bool Vertex<T, W, WeightType>::operator<=(const Vertex<T, W, WeightType> &that) const
 	{
 		return static_cast<const void*>(this) <= static_cast<const void*>(&that);
 	}
 
-	template<typename T>
-	bool Vertex<T>::operator<(const Vertex<T> &that) const
+	template<typename T, Weighting W, class WeightType>
+	bool Vertex<T, W, WeightType>::operator<(const Vertex<T, W, WeightType> &that) const
 	{
 		return static_cast<const void*>(this) < static_cast<const void*>(&that);
 	}
 
-	template<typename T>
-	bool Vertex<T>::operator==(const Vertex<T> &that) const
+	template<typename T, Weighting W, class WeightType>
+	bool Vertex<T, W, WeightType>::operator==(const Vertex<T, W, WeightType> &that) const
 	{
 		return static_cast<const void*>(this) == static_cast<const void*>(&that);
 	}
 
-	template<typename T>
-	bool Vertex<T>::operator>=(const Vertex<T> &that) const
+	template<typename T, Weighting W, class WeightType>
+	bool Vertex<T, W, WeightType>::operator>=(const Vertex<T, W, WeightType> &that) const
 	{
 		return static_cast<const void*>(this) >= static_cast<const void*>(&that);
 	}
 
-	template<typename T>
-	bool Vertex<T>::operator>(const Vertex<T> &that) const
+	template<typename T, Weighting W, class WeightType>
+	bool Vertex<T, W, WeightType>::operator>(const Vertex<T, W, WeightType> &that) const
 	{
 		return static_cast<const void*>(this) > static_cast<const void*>(&that);
 	}
 
-	template<typename T>
-	bool Vertex<T>::operator!=(const Vertex<T> &that) const
+	template<typename T, Weighting W, class WeightType>
+	bool Vertex<T, W, WeightType>::operator!=(const Vertex<T, W, WeightType> &that) const
 	{
 		return static_cast<const void*>(this) != static_cast<const void*>(&that);
 	}
 
-	template<typename T>
-	std::list<boost::tuple<Vertex<T>*, int> > Vertex<T>::Neighborhood(void)
+	template<typename T, Weighting W, class WeightType>
+	const typename Vertex<T, W, WeightType>::EdgeList &Vertex<T, W, WeightType>::Neighborhood(void) const
 	{
 		return neighborhood;
 	}
 
-	template<typename T>
-	std::list<Vertex<T>*> Vertex<T>::Neighbors(void)
+	template<typename T, Weighting W, class WeightType>
+	typename Vertex<T, W, WeightType>::EdgeIterator Vertex<T, W, WeightType>::EdgesBegin(void) const
+	{
+		return neighborhood.begin();
+	}
+
+	template<typename T, Weighting W, class WeightType>
+	typename Vertex<T, W, WeightType>::EdgeIterator Vertex<T, W, WeightType>::EdgesEnd(void) const
+	{
+		return neighborhood.end();
+	}
+
+	template<typename T, Weighting W, class WeightType>
+	int Vertex<T, W, WeightType>::Degree(void) const
+	{
+		return neighborhood.size();
+	}
+
+	template<typename T, Weighting W, class WeightType>
+	template<class Visitor>
+	Visitor Vertex<T, W, WeightType>::ForEachEdge(Visitor visitor) const
+	{
+		for (EdgeIterator i = neighborhood.begin(); i != neighborhood.end(); i++)
+			visitor(boost::get<0>(*i), Storage::Weight(*i));
+		return visitor;
+	}
+
+	template<typename T, Weighting W, class WeightType>
+	std::list<Vertex<T, W, WeightType>*> Vertex<T, W, WeightType>::Neighbors(void)
 	{
-		std::list<Vertex<T>*> neighbors;	// The neigbors.
+		std::list<Vertex<T, W, WeightType>*> neighbors;	// The neigbors.
 
 // 		std::transform(neighborhood.begin(), neighborhood.end(), neighbors.begin(), boost::lambda::bind(&GetVertexFromTuple, boost::lambda::_1));
-		std::for_each(neighborhood.begin(), neighborhood.end(), boost::lambda::bind(&std::list<Vertex<T>*>::push_back, var(neighbors), boost::lambda::bind(&GetVertexFromTuple, boost::lambda::_1)));
+		for (EdgeIterator i = EdgesBegin(); i != EdgesEnd(); i++)
+			neighbors.push_back(boost::get<0>(*i));
 		return neighbors;
 	}
 
-	template<typename T>
-	std::ostream &Vertex<T>::Dump(std::ostream &outStream) const
+	template<typename T, Weighting W, class WeightType>
+	std::ostream &Vertex<T, W, WeightType>::Dump(std::ostream &outStream) const
 	{
  		outStream << mrRogers;
-		for_each(neighborhood.begin(), neighborhood.end(), boost::lambda::var(outStream) << boost::lambda::constant(" -> ") << boost::lambda::bind(&Vertex<T>::Get, *boost::lambda::bind<Vertex<T>*>(&Vertex<T>::GetVertexFromTuple, boost::lambda::_1)) << boost::lambda::constant(":") << boost::lambda::bind<int>(&Vertex<T>::GetWeightFromTuple, boost::lambda::_1));
+		for_each(neighborhood.begin(), neighborhood.end(), boost::lambda::var(outStream) << boost::lambda::constant(" -> ") << boost::lambda::bind(&Vertex<T, W, WeightType>::Get, *boost::lambda::bind<Vertex<T, W, WeightType>*>(&Vertex<T, W, WeightType>::GetVertexFromTuple, boost::lambda::_1)) << boost::lambda::constant(":") << boost::lambda::bind<int>(&Vertex<T, W, WeightType>::GetWeightFromTuple, boost::lambda::_1));
 		return outStream;
 	}
 
-	template<typename T>
-	std::ostream &operator<< (std::ostream &out, const Vertex<T> &vertex)
+	template<typename T, Weighting W, class WeightType>
+	std::ostream &operator<< (std::ostream &out, const Vertex<T, W, WeightType> &vertex)
 	{
 		return vertex.Dump(out);
 	}
 
-	template<typename T>
-	int Vertex<T>::GetWeightFromTuple(boost::tuple<Vertex<T>*, int> myTuple)
+	template<typename T, Weighting W, class WeightType>
+	int Vertex<T, W, WeightType>::GetWeightFromTuple(const Edge &myTuple)
 	{
-		return boost::get<1>(myTuple);
+		return Storage::Weight(myTuple);
 	}
 
-	template<typename T>
-	Vertex<T>* Vertex<T>::GetVertexFromTuple(boost::tuple<Vertex<T>*, int> myTuple)
+	template<typename T, Weighting W, class WeightType>
+	Vertex<T, W, WeightType>* Vertex<T, W, WeightType>::GetVertexFromTuple(const Edge &myTuple)
 	{
 		return boost::get<0>(myTuple);
 	}
 
-	template<typename T>
-	int Vertex<T>::GetWeight(const Vertex<T> &otherVertex) const
+	template<typename T, Weighting W, class WeightType>
+	int Vertex<T, W, WeightType>::GetWeight(const Vertex<T, W, WeightType> &otherVertex) const
+	{
+		if (weightIndex != NULL)
+		{
+			typename boost::unordered_map<const Vertex<T, W, WeightType>*, int>::const_iterator found = weightIndex->find(&otherVertex);
+
+			return found == weightIndex->end() ? Infinity : found->second;
+		}
+
+		EdgeIterator found = find_if(neighborhood.begin(), neighborhood.end(), boost::lambda::bind(&GetVertexFromTuple, boost::lambda::_1) == boost::lambda::constant(&otherVertex));
+
+		return found == neighborhood.end() ? Infinity : GetWeightFromTuple(*found);
+	}
+
+	template<typename T, Weighting W, class WeightType>
+	void Vertex<T, W, WeightType>::IndexWeights(bool enable)
+	{
+		if (!enable)
+		{
+			delete weightIndex;
+			weightIndex = NULL;
+			return;
+		}
+		if (weightIndex != NULL)
+			return;
+
+		/*
+		Walk backwards so the first edge to each neighbor is the one that sticks.
+		*/
+		weightIndex = new boost::unordered_map<const Vertex<T, W, WeightType>*, int>(neighborhood.size());
+		for (typename EdgeList::const_reverse_iterator i = neighborhood.rbegin(); i != neighborhood.rend(); i++)
+			(*weightIndex)[boost::get<0>(*i)] = Storage::Weight(*i);
+		return;
+	}
+
+	template<typename T, Weighting W, class WeightType>
+	int Vertex<T, W, WeightType>::Index(void) const
 	{
-		return GetWeightFromTuple(*find_if(neighborhood.begin(), neighborhood.end(), boost::lambda::bind(&GetVertexFromTuple, boost::lambda::_1) == boost::lambda::constant(&otherVertex)));
+		return index;
 	}
 }
 